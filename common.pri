@@ -13,7 +13,9 @@ QMAKE_CXXFLAGS += -Wall -Wextra -pedantic
 
 SOURCES +=  $$files($$PROJ_DIR"/src/physics/*.cpp")\
             $$files($$PROJ_DIR"/src/algorithms/*.cpp")\
+            $$files($$PROJ_DIR"/src/generators/*.cpp")\
 
 HEADERS +=  $$files($$PROJ_DIR"/src/physics/*.h")\
             $$files($$PROJ_DIR"/src/algorithms/*.h")\
+            $$files($$PROJ_DIR"/src/generators/*.h")\
             $$PROJ_DIR"/src/exceptions.h"\
@@ -1,10 +1,13 @@
 # build multiple targets, e.g. the GUI and the CLI version
 TEMPLATE = subdirs
-SUBDIRS = cmd gui tests
+SUBDIRS = cmd gui tests decompress validate benchmarks
  
 gui.file = src/nsim.gui.pro
 cmd.file = src/nsim.cmd.pro
+decompress.file = src/nsim.decompress.pro
+validate.file = src/nsim.validate.pro
 tests.file = tests/unit/tests.pro
+benchmarks.file = tests/benchmarks/benchmarks.pro
 
 # build the documentation with 'make docs'
 docs.target = docs
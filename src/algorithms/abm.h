@@ -44,6 +44,14 @@ public:
 
     void reset();
 
+    History getHistory() const override {
+        return history;
+    }
+
+    void setHistory(const History& h) override {
+        history = h;
+    }
+
     Type getType();
 protected:
     void computeStepImplementation(physics::UniverseModel *universe,
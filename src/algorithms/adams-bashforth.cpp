@@ -47,6 +47,7 @@ AdamsBashforth::computeStepImplementation(
         RungeKutta rk4(4, true);
         rk4.computeStep(universe, time_step);
         history.push_back(rk4.getLastStepData());
+        force_evaluations += rk4.forceEvaluations();
         return;
     }
     assert(history.size() == order-1);
@@ -68,6 +68,7 @@ Base::computeAcceleration(const physics::UniverseModel *universe,
                           const physics::Vector& position)
 {
     physics::Vector result;
+    force_evaluations += universe->size() - 1;
     for(const auto& body2 : *universe) {
         if(&body == &body2) continue;
 
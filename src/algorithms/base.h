@@ -26,6 +26,7 @@
 #ifndef __BASEALGORITHM_H__
 #define __BASEALGORITHM_H__
 
+#include <cstdint>
 #include <deque>
 #include <vector>
 #include "physics/precision.h"
@@ -101,14 +102,39 @@ public:
      */
     virtual void reset() {}
 
+    /** Get the internal state of the algorithm that was built up by the
+     * previous steps, e.g. the history of the Adams algorithms. Single-step
+     * methods return an empty history. Together with the universe model, it
+     * is enough to continue the computation exactly as if it wasn't
+     * interrupted.
+     */
+    virtual History getHistory() const {
+        return History();
+    }
+
+    /** Restore the internal state saved by Base::getHistory.
+     */
+    virtual void setHistory(const History&) {}
+
     /// Get the type of algorithm.
     virtual Type getType() = 0;
 
+    /** Number of forces between two bodies computed since the algorithm was
+     * created. Used to compare the cost of the algorithms independently of
+     * the machine.
+     */
+    std::uint64_t forceEvaluations() const {
+        return force_evaluations;
+    }
+
 protected:
     /// The order of the numeric integrator, used only by algorithms that
     /// are available in more orders. Is equal to zero if unused.
     unsigned order;
 
+    /// @see Base::forceEvaluations
+    std::uint64_t force_evaluations = 0;
+
     virtual void computeStepImplementation(physics::UniverseModel *universe,
                                            physics::DOUBLE time_step) = 0;
 
@@ -31,6 +31,15 @@
 
 namespace parser
 {
+QString formatNames()
+{
+    QString result;
+    for(unsigned i = 0; i < output::formatName.size(); ++i) {
+        result += output::formatName[i] + "\n";
+    }
+    return result;
+}
+
 QString algorithmNames()
 {
     QString result;
@@ -90,6 +99,23 @@ ArgumentsParser::ArgumentsParser(const QCoreApplication& app)
             QCoreApplication::translate("main",
             "Center the output so that the barycenter (center of mass) has"
             " coordinates [0, 0, 0]. Off by default.")
+        },
+        {   "output-format",
+            QCoreApplication::translate("main",
+            "Format of the results. Default is 'text', the 'npy' formats"
+            " write a NumPy array with the time and positions of the bodies"
+            " in float64. Possible options are:\n") + formatNames(),
+            QCoreApplication::translate("main", "format")
+        },
+        {   {"o", "output"},
+            QCoreApplication::translate("main",
+            "Write the results to the file instead of the standard output."),
+            QCoreApplication::translate("main", "file")
+        },
+        {   {"z", "compress"},
+            QCoreApplication::translate("main",
+            "Compress the results with zlib while they are written. Use"
+            " nsim-decompress to read them. Off by default.")
         }
     });
     parser.process(app);
@@ -111,6 +137,22 @@ ArgumentsParser::ArgumentsParser(const QCoreApplication& app)
             throw Exception("Invalid algorithm type.");
     }
 
+    QString formatStr = parser.value("output-format");
+    if(!formatStr.isEmpty()) {
+        bool valid = false;
+        for(unsigned i = 0; i < output::formatName.size(); ++i) {
+            if(formatStr == output::formatName[i]) {
+                valid = true;
+                output_format = (output::Format) i;
+                break;
+            }
+        }
+        if(valid == false)
+            throw Exception("Invalid output format.");
+    }
+    output_file = parser.value("output");
+    compress = parser.isSet("compress");
+
     if(parser.isSet("time"))
         simulation_time = parser.value("time").toDouble();
     if(parser.isSet("step"))
@@ -138,5 +180,6 @@ ArgumentsParser::ArgumentsParser(const QCoreApplication& app)
     qDebug() << "time step: " << time_step;
     qDebug() << "print interval: " << print_interval;
     qDebug() << "algorithm: " << algorithms::typeName[algorithm];
+    qDebug() << "output format: " << output::formatName[output_format];
 }
 }  // namespace
@@ -26,6 +26,7 @@
 
 #include <QString>
 #include "algorithms/types.h"
+#include "output/types.h"
 
 class QCoreApplication;
 
@@ -77,6 +78,17 @@ struct ArgumentsParser {
     /// body in the input file.
     /// @exception ParserException if center_to_barycenter was given too.
     unsigned center_body_index = 0;
+
+    /// Format of the printed results.
+    /// @exception ParserException if not part of output::formatName.
+    output::Format output_format = output::DEFAULT_FORMAT;
+
+    /// File where the results are written, set with `-o`. The standard
+    /// output is used if empty.
+    QString output_file;
+
+    /// Should the results be compressed, see output::CompressingBuffer?
+    bool compress = false;
 };
 }  // namespace
 
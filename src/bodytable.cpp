@@ -0,0 +1,282 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ */
+
+#include "bodytable.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <QFile>
+#include <QByteArray>
+#include <QThread>
+#include <QtEndian>
+#include <QDebug>
+#include "exceptions.h"
+
+namespace parser
+{
+namespace
+{
+/// Number of values per body in the binary table.
+const unsigned BINARY_COLUMNS = 7;
+
+/// Name of all the bodies from tables, shared by them.
+const QString BODY_NAME = "body";
+
+/// Parts smaller than this aren't worth a thread.
+const qint64 MIN_PART_SIZE = 1 << 20;
+
+/// Part of the mapped file processed by one thread.
+struct Part {
+    const uchar *begin;
+    const uchar *end;
+    /// Number of the first line in the part, counted from 1.
+    unsigned first_line = 1;
+    /// Index of the first body of the part in the table.
+    std::size_t first_body = 0;
+    /// Number of bodies in the part.
+    std::size_t bodies = 0;
+    /// Number of lines in the part.
+    unsigned lines = 0;
+    QString error;
+};
+
+/// Split the data into parts for the threads, each ending at @p separator
+/// (the parts of binary tables at whole records).
+std::vector<Part> split(const uchar *data, qint64 size, qint64 alignment,
+                        int separator)
+{
+    const qint64 count = qBound<qint64>(1, size / MIN_PART_SIZE,
+                                        QThread::idealThreadCount());
+    std::vector<Part> parts(count);
+    const uchar *begin = data;
+    for(qint64 i = 0; i < count; i++) {
+        const uchar *end = data + (i + 1) * (size / count / alignment)
+                                  * alignment;
+        if(i == count - 1 || end < begin) {
+            end = data + size;
+        } else if(separator >= 0) {
+            auto found = static_cast<const uchar*>(
+                std::memchr(end, separator, data + size - end));
+            end = found ? found + 1 : data + size;
+        }
+        parts[i].begin = begin;
+        parts[i].end = end;
+        begin = end;
+    }
+    return parts;
+}
+
+/// Call the function for every part in its own thread. Errors are stored in
+/// Part::error and thrown afterwards.
+template<typename Function>
+void inParallel(std::vector<Part> *parts, Function function)
+{
+    std::vector<std::thread> threads;
+    for(auto& part : *parts) {
+        threads.emplace_back([&part, &function]() {
+            try {
+                function(&part);
+            } catch(const std::exception& e) {
+                part.error = e.what();
+            }
+        });
+    }
+    for(auto& thread : threads)
+        thread.join();
+    for(const auto& part : *parts) {
+        if(!part.error.isEmpty())
+            throw Exception(part.error);
+    }
+}
+
+/// Find the next line in [p, end) and move p after it. The returned line
+/// doesn't contain the line break.
+void nextLine(const uchar **p, const uchar *end,
+              const uchar **line_begin, const uchar **line_end)
+{
+    *line_begin = *p;
+    auto found = static_cast<const uchar*>(std::memchr(*p, '\n', end - *p));
+    *line_end = found ? found : end;
+    *p = found ? found + 1 : end;
+    if(*line_end > *line_begin && (*line_end)[-1] == '\r')
+        (*line_end)--;
+}
+
+bool isSpace(uchar c)
+{
+    return c == ' ' || c == '\t';
+}
+
+/// Is there a body on the line (not a comment or an empty line)?
+bool isDataLine(const uchar *begin, const uchar *end)
+{
+    while(begin < end && isSpace(*begin))
+        begin++;
+    return begin < end && *begin != '#';
+}
+
+/// Parse the comma separated numbers on the line, returns their count.
+unsigned parseNumbers(const uchar *begin, const uchar *end,
+                      double *numbers, unsigned max_count)
+{
+    unsigned count = 0;
+    while(begin <= end) {
+        auto comma = static_cast<const uchar*>(
+            std::memchr(begin, ',', end - begin));
+        const uchar *field_end = comma ? comma : end;
+        const uchar *field_begin = begin;
+        while(field_begin < field_end && isSpace(*field_begin))
+            field_begin++;
+        while(field_end > field_begin && isSpace(field_end[-1]))
+            field_end--;
+        if(count == max_count)
+            return max_count + 1;
+        bool ok;
+        // QByteArray converts numbers independently of the locale
+        numbers[count++] = QByteArray::fromRawData(
+            reinterpret_cast<const char*>(field_begin),
+            field_end - field_begin).toDouble(&ok);
+        if(!ok)
+            return 0;
+        if(!comma)
+            break;
+        begin = comma + 1;
+    }
+    return count;
+}
+
+void loadCsv(const QString& file_name, const uchar *data, qint64 size,
+             physics::UniverseModel *universe)
+{
+    std::vector<Part> parts = split(data, size, 1, '\n');
+
+    // first count the bodies, so that all of them can be parsed in place
+    inParallel(&parts, [](Part *part) {
+        const uchar *p = part->begin;
+        const uchar *line_begin, *line_end;
+        while(p < part->end) {
+            nextLine(&p, part->end, &line_begin, &line_end);
+            part->lines++;
+            if(isDataLine(line_begin, line_end))
+                part->bodies++;
+        }
+    });
+    const std::size_t first = universe->size();
+    std::size_t bodies = 0;
+    unsigned lines = 0;
+    for(auto& part : parts) {
+        part.first_body = bodies;
+        part.first_line = lines + 1;
+        bodies += part.bodies;
+        lines += part.lines;
+    }
+    universe->resize(first + bodies);
+
+    inParallel(&parts, [&](Part *part) {
+        const uchar *p = part->begin;
+        const uchar *line_begin, *line_end;
+        unsigned line = part->first_line;
+        physics::Body *body = universe->data() + first + part->first_body;
+        for(; p < part->end; line++) {
+            nextLine(&p, part->end, &line_begin, &line_end);
+            if(!isDataLine(line_begin, line_end))
+                continue;
+            double n[8];
+            const unsigned count = parseNumbers(line_begin, line_end, n, 8);
+            if(count != 7 && count != 8) {
+                throw Exception(QString("Invalid body on line %1 of %2,"
+                                        " expected mass, position, velocity"
+                                        " and optionally radius")
+                                .arg(line).arg(file_name));
+            }
+            body->name = BODY_NAME;
+            body->mass = n[0];
+            body->position.set(n[1], n[2], n[3]);
+            body->velocity.set(n[4], n[5], n[6]);
+            if(count == 8)
+                body->radius = n[7];
+            body++;
+        }
+    });
+}
+
+void loadBinary(const QString& file_name, const uchar *data, qint64 size,
+                physics::UniverseModel *universe)
+{
+    const qint64 record = BINARY_COLUMNS * sizeof(double);
+    if(size % record != 0) {
+        throw Exception(QString("The size of %1 isn't a multiple of %2 bytes"
+                                " (mass, position and velocity in float64)")
+                        .arg(file_name).arg(record));
+    }
+    std::vector<Part> parts = split(data, size, record, -1);
+    const std::size_t first = universe->size();
+    universe->resize(first + size / record);
+
+    inParallel(&parts, [&](Part *part) {
+        physics::Body *body = universe->data() + first
+                              + (part->begin - data) / record;
+        for(const uchar *p = part->begin; p < part->end; p += record) {
+            double n[BINARY_COLUMNS];
+            for(unsigned i = 0; i < BINARY_COLUMNS; i++) {
+                const quint64 bits = qFromLittleEndian<quint64>(
+                    p + i * sizeof(double));
+                std::memcpy(&n[i], &bits, sizeof(double));
+            }
+            body->name = BODY_NAME;
+            body->mass = n[0];
+            body->position.set(n[1], n[2], n[3]);
+            body->velocity.set(n[4], n[5], n[6]);
+            body++;
+        }
+    });
+}
+}  // namespace
+
+void loadBodyTable(const QString& file_name, BodyTableFormat format,
+                   physics::UniverseModel *universe)
+{
+    QFile file(file_name);
+    if(!file.open(QFile::ReadOnly)) {
+        throw Exception("Can't read file " + file_name + ": "
+                        + file.errorString());
+    }
+    const qint64 size = file.size();
+    if(size == 0)
+        return;
+    const uchar *data = file.map(0, size);
+    if(!data)
+        throw Exception("Can't map file " + file_name + ": "
+                        + file.errorString());
+
+    const std::size_t before = universe->size();
+    if(format == BodyTableFormat::CSV)
+        loadCsv(file_name, data, size, universe);
+    else
+        loadBinary(file_name, data, size, universe);
+    qDebug() << "parser:" << universe->size() - before << "bodies loaded from"
+             << file_name;
+    // the file is unmapped when it is closed
+}
+}  // namespace
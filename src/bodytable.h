@@ -0,0 +1,62 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ * Loading of large sets of bodies from CSV or binary tables.
+ */
+
+#ifndef __BODYTABLE_H__
+#define __BODYTABLE_H__
+
+#include <QString>
+#include "physics/universemodel.h"
+
+namespace parser
+{
+/**
+ * Formats of the tables with bodies referenced from the project file by
+ * `<bodies file="..." format="..."/>`. Every body has the mass, the x, y, z
+ * coordinates of the position and the x, y, z components of the velocity,
+ * in the units of the project.
+ */
+enum class BodyTableFormat {
+    /// Text with one body per line and 7 comma separated numbers - mass,
+    /// position and velocity - optionally followed by the radius. Empty
+    /// lines and lines starting with `#` are skipped.
+    CSV,
+    /// Records of 7 little-endian float64 numbers - mass, position and
+    /// velocity - without any header.
+    BINARY
+};
+
+/**
+ * Append the bodies from the table to the universe. The file is memory
+ * mapped and split into parts parsed in parallel, so large tables load
+ * about as fast as the disk can read them.
+ *
+ * The bodies are named "body" and have the default radius, unless the CSV
+ * table gives it.
+ * @throw Exception if the file can't be read or has an invalid format
+ */
+void loadBodyTable(const QString& file_name, BodyTableFormat format,
+                   physics::UniverseModel *universe);
+}  // namespace
+
+#endif  // __BODYTABLE_H__
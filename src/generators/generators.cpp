@@ -0,0 +1,232 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ */
+
+#include "generators/generators.h"
+
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <QThread>
+#include "algorithms/base.h"
+#include "exceptions.h"
+
+namespace generators
+{
+namespace
+{
+const physics::DOUBLE PI = 3.14159265358979323846264338327950288L;
+
+/// Plummer spheres are cut at this multiple of the Plummer radius, there
+/// would be a few bodies extremely far away otherwise.
+const physics::DOUBLE PLUMMER_CUTOFF = 10;
+
+/// Mass of the whole Kepler disk relative to the central body.
+const physics::DOUBLE DISK_MASS_RATIO = 1e-3;
+
+/// The disk of the M_KEPLER_DISK starts at this fraction of its radius.
+const physics::DOUBLE DISK_INNER_RADIUS = 0.1;
+
+/// Fewer bodies than this are generated in one thread.
+const unsigned MIN_BODIES_PER_THREAD = 10000;
+
+/**
+ * Random numbers for one body, the SplitMix64 generator seeded by the seed
+ * and the index of the body.
+ */
+class Random
+{
+public:
+    Random(std::uint64_t seed, std::uint64_t index)
+        : state(seed ^ (index * 0xd1342543de82ef95ULL)) {
+        next();
+    }
+
+    /// Uniformly distributed in [0, 1).
+    physics::DOUBLE uniform() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    /// Uniformly distributed in [from, to).
+    physics::DOUBLE uniform(physics::DOUBLE from, physics::DOUBLE to) {
+        return from + (to - from) * uniform();
+    }
+
+    /// Random direction with the given length.
+    physics::Vector direction(physics::DOUBLE length) {
+        const physics::DOUBLE z = uniform(-1, 1);
+        const physics::DOUBLE phi = uniform(0, 2 * PI);
+        const physics::DOUBLE r = std::sqrt(1 - z * z);
+        return physics::Vector(r * std::cos(phi), r * std::sin(phi), z)
+               * length;
+    }
+
+private:
+    std::uint64_t next() {
+        std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    std::uint64_t state;
+};
+
+/// Plummer model sampled as in Aarseth, Henon & Wielen (1974).
+void plummer(const Parameters& p, physics::Body *body, Random *random)
+{
+    const physics::DOUBLE a = p.radius;
+    physics::DOUBLE r;
+    do {
+        const physics::DOUBLE x = random->uniform(1e-10, 1);
+        r = a / std::sqrt(std::pow(x, -2.0L / 3) - 1);
+    } while(r > PLUMMER_CUTOFF * a);
+    body->position = random->direction(r);
+
+    // ratio to the escape velocity, from g(q) = q^2 (1 - q^2)^3.5
+    physics::DOUBLE q, g;
+    do {
+        q = random->uniform();
+        g = random->uniform(0, 0.1);
+    } while(g > q * q * std::pow(1 - q * q, 3.5L));
+    const physics::DOUBLE escape = std::sqrt(2 * algorithms::G * p.mass)
+                                   * std::pow(r * r + a * a, -0.25L);
+    body->velocity = random->direction(q * escape);
+}
+
+void keplerDisk(const Parameters& p, physics::Body *body, Random *random)
+{
+    // uniform surface density between the inner and outer radius
+    const physics::DOUBLE inner = DISK_INNER_RADIUS * p.radius;
+    const physics::DOUBLE r = std::sqrt(random->uniform(inner * inner,
+                                                        p.radius * p.radius));
+    const physics::DOUBLE phi = random->uniform(0, 2 * PI);
+    const physics::DOUBLE v = std::sqrt(algorithms::G * p.mass / r);
+    body->position.set(r * std::cos(phi), r * std::sin(phi), 0);
+    body->velocity.set(-v * std::sin(phi), v * std::cos(phi), 0);
+}
+
+void uniformCube(const Parameters& p, physics::Body *body, Random *random)
+{
+    const physics::DOUBLE v = std::sqrt(algorithms::G * p.mass / p.radius);
+    body->position.set(random->uniform(-p.radius, p.radius),
+                       random->uniform(-p.radius, p.radius),
+                       random->uniform(-p.radius, p.radius));
+    body->velocity.set(random->uniform(-v, v) / 2,
+                       random->uniform(-v, v) / 2,
+                       random->uniform(-v, v) / 2);
+}
+
+void coldCollapse(const Parameters& p, physics::Body *body, Random *random)
+{
+    const physics::DOUBLE r = p.radius * std::cbrt(random->uniform());
+    body->position = random->direction(r);
+    body->velocity = physics::Vector();
+}
+
+/// Move the center of mass to the origin and stop it.
+void centerOfMassFrame(physics::UniverseModel *universe)
+{
+    physics::DOUBLE mass = 0;
+    physics::Vector position, velocity;
+    for(const auto& body : *universe) {
+        mass += body.mass;
+        position += body.position * body.mass;
+        velocity += body.velocity * body.mass;
+    }
+    if(mass <= 0)
+        return;
+    position /= mass;
+    velocity /= mass;
+    for(auto& body : *universe) {
+        body.position -= position;
+        body.velocity -= velocity;
+    }
+}
+}  // namespace
+
+physics::UniverseModel generate(const Parameters& parameters)
+{
+    if(parameters.count == 0)
+        throw Exception("Nothing to generate, the count of bodies is 0.");
+    if(!(parameters.mass > 0) || !(parameters.radius > 0))
+        throw Exception("The generated mass and radius have to be positive.");
+
+    void (*generator)(const Parameters&, physics::Body*, Random*) = nullptr;
+    switch(parameters.model) {
+    case M_PLUMMER:
+        generator = plummer;
+        break;
+    case M_KEPLER_DISK:
+        generator = keplerDisk;
+        break;
+    case M_UNIFORM_CUBE:
+        generator = uniformCube;
+        break;
+    case M_COLD_COLLAPSE:
+        generator = coldCollapse;
+        break;
+    default:
+        throw Exception("Unknown generator model");
+    }
+
+    physics::UniverseModel universe(parameters.count);
+    const QString name = "body";
+    physics::DOUBLE body_mass = parameters.mass / parameters.count;
+    unsigned first = 0;
+    if(parameters.model == M_KEPLER_DISK) {
+        universe[0].name = "center";
+        universe[0].mass = parameters.mass;
+        first = 1;
+        body_mass = parameters.count > 1
+                    ? parameters.mass * DISK_MASS_RATIO
+                      / (parameters.count - 1)
+                    : 0;
+    }
+
+    const unsigned threads = qBound(1u, parameters.count
+                                        / MIN_BODIES_PER_THREAD,
+                                    unsigned(std::max(
+                                        1, QThread::idealThreadCount())));
+    std::vector<std::thread> workers;
+    for(unsigned t = 0; t < threads; t++) {
+        const unsigned begin = first + std::uint64_t(parameters.count - first)
+                                       * t / threads;
+        const unsigned end = first + std::uint64_t(parameters.count - first)
+                                     * (t + 1) / threads;
+        workers.emplace_back([&, begin, end]() {
+            for(unsigned i = begin; i < end; i++) {
+                Random random(parameters.seed, i);
+                universe[i].name = name;
+                universe[i].mass = body_mass;
+                generator(parameters, &universe[i], &random);
+            }
+        });
+    }
+    for(auto& worker : workers)
+        worker.join();
+
+    if(parameters.model != M_KEPLER_DISK)
+        centerOfMassFrame(&universe);
+    return universe;
+}
+}  // namespace
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ * Generators of synthetic universes of any size.
+ */
+
+#ifndef __GENERATORS_H__
+#define __GENERATORS_H__
+
+#include <cstdint>
+#include <vector>
+#include <QString>
+#include "physics/universemodel.h"
+
+/**
+ * @namespace generators Initial conditions for benchmarks and stress tests
+ *
+ * The generators create a UniverseModel with many bodies from a few
+ * parameters. The bodies are generated in parallel, but each body gets
+ * random numbers derived only from the seed and its index, so the same
+ * parameters always give the same universe.
+ */
+namespace generators
+{
+/**
+ * Models of the generated universes.
+ * @note The order of the values has to correspond to generators::modelName.
+ */
+enum Model {
+    /// Plummer sphere in equilibrium, with the Plummer radius
+    /// Parameters::radius.
+    M_PLUMMER = 0,
+    /// A central body with the Parameters::mass and light bodies on
+    /// circular orbits around it, in a flat disk with the
+    /// Parameters::radius.
+    M_KEPLER_DISK,
+    /// Bodies spread uniformly in a cube with the edge 2 * radius, with
+    /// random velocities of the order of the virial velocity.
+    M_UNIFORM_CUBE,
+    /// Bodies spread uniformly in a sphere with the radius, at rest.
+    M_COLD_COLLAPSE
+};
+
+/**
+ * Names of the models used in the project file.
+ * @note The order of the names has to correspond to the
+ *      `enum` generators::Model.
+ */
+const std::vector<QString> modelName {
+    "plummer",
+    "kepler-disk",
+    "uniform-cube",
+    "cold-collapse"
+};
+
+/// What should be generated, in meters, kilograms and seconds.
+struct Parameters {
+    Model model = M_PLUMMER;
+    /// Number of generated bodies.
+    unsigned count = 1000;
+    /// Total mass of the bodies, or the mass of the central body of the
+    /// M_KEPLER_DISK.
+    physics::DOUBLE mass = 1;
+    /// Size of the generated system, see generators::Model.
+    physics::DOUBLE radius = 1;
+    /// Universes generated with the same seed are identical.
+    std::uint64_t seed = 1;
+};
+
+/**
+ * Generate the universe. The bodies are named "body" and, except for the
+ * M_KEPLER_DISK, their center of mass is at rest in the origin.
+ * @throw Exception if the parameters are invalid
+ */
+physics::UniverseModel generate(const Parameters& parameters);
+}  // namespace
+
+#endif  // __GENERATORS_H__
@@ -22,18 +22,28 @@
  */
 #include "gui/animation.h"
 
+#include <algorithm>
 #include <QMouseEvent>
 #include <QDebug>
-#include "exceptions.h"
 
-const int TIMER_TIMEOUT = 12;
+/// At speed 1, the animation moves by this many saved states in a second of
+/// real time (one state per 12 ms).
+const double STATES_PER_SECOND = 1000.0 / 12;
+/// Approximately how many positions of each orbit should be written into the
+/// OpenGL buffers in one frame, regardless of the animation speed.
+const int ORBIT_SAMPLES_PER_FRAME = 16;
+/// The slowest speed of the animation, relative to STATES_PER_SECOND.
+const float MIN_SPEED = 1.0/64;
 
 
 Animation::Animation(QWidget *parent,
                      std::shared_ptr<SimulationHistory> const history)
-    : QOpenGLWidget(parent), simulation_history(history)
+    : QOpenGLWidget(parent), renderer(history), simulation_history(history)
 {
     logger = new QOpenGLDebugLogger(this);
+    // draw the next frame as soon as the previous one is on the screen, i.e.
+    // paced by the vertical sync
+    connect(this, SIGNAL(frameSwapped()), this, SLOT(advance()));
 }
 
 Animation::~Animation()
@@ -48,13 +58,9 @@ Animation::~Animation()
 void
 Animation::loadUniverse(physics::UniverseModel u, parser::ProjectSettings p)
 {
-    universe = u;
-    settings = p;
-    orbits.clear();
-    for (unsigned i = 0; i < universe.size(); i++) {
-        orbits.push_back(Orbit(simulation_history, i));
-        orbits[i].initialize();
-    }
+    makeCurrent();
+    renderer.loadUniverse(u, p);
+    doneCurrent();
     reset();
 }
 
@@ -63,32 +69,95 @@ void
 Animation::reset()
 {
     history_index = 0;
+    history_position = 0;
+    playback_time = hasData() ? simulation_history->savedTime(0) : 0;
     view_translation = QVector3D();
     view_rotation = QQuaternion();
-    view_scale = 1.0/computeUniverseRadius();
+    view_scale = 1.0/renderer.universeRadius();
     speed = 1;
     update();
 }
 
+void
+Animation::seek(physics::DOUBLE time)
+{
+    if (!hasData()) return;
+    const HistoryPosition position = simulation_history->seek(time);
+    history_index = position.index;
+    history_position = position.index + position.factor;
+    playback_time = simulation_history->savedTime(position.index)
+                    + position.factor
+                    * (simulation_history->savedTime(position.next)
+                       - simulation_history->savedTime(position.index));
+    makeCurrent();
+    renderer.seek(history_index);
+    doneCurrent();
+    update();
+}
+
 void
 Animation::startOrStop(bool start)
 {
     if(!hasData()) return;
 
     this->setFocus();
+    playing = start;
     if (start) {
         emit stateChanged(PLAYING);
-        timer.start(TIMER_TIMEOUT, this);
+        playback_clock.start();
+        update();
     } else {
         emit stateChanged(PAUSED);
-        timer.stop();
     }
 }
 
+double
+Animation::playbackRate()
+{
+    if (simulation_history->historySize() < 2) return 0;
+    // the saved states are approximately equally spaced
+    const physics::DOUBLE interval = simulation_history->savedTime(1)
+                                     - simulation_history->savedTime(0);
+    return speed * STATES_PER_SECOND * interval;
+}
+
+void
+Animation::advance()
+{
+    if (!playing || !hasData()) return;
+    Q_ASSERT(speed >= MIN_SPEED);
+    // move by the real time since the last frame, so that a slow or dropped
+    // frame skips ahead instead of slowing the playback down
+    const double elapsed = playback_clock.nsecsElapsed() / 1e9;
+    playback_clock.start();
+    const double rate = playbackRate();
+    const physics::DOUBLE last = simulation_history->savedTime(
+                                     simulation_history->historySize() - 1);
+    playback_time = std::min(playback_time + rate * elapsed, last);
+
+    const HistoryPosition position = simulation_history->seek(playback_time);
+    const unsigned previous_index = history_index;
+    history_index = position.index;
+    history_position = position.index + position.factor;
+    // when moving fast, skip the positions that wouldn't be visible anyway
+    const unsigned level = SimulationHistory::levelForStride(
+        (history_index - std::min(previous_index, history_index))
+        / ORBIT_SAMPLES_PER_FRAME);
+    makeCurrent();
+    renderer.updateTrajectories(history_index, level);
+    doneCurrent();
+
+    emit playbackAdvanced(playback_time, rate);
+    update();
+}
+
 void
 Animation::increaseSpeed()
 {
-    speed++;
+    if(speed < 1)
+        speed *= 2;
+    else
+        speed++;
     if(speed > 10000) speed = 10000;
     update();
 }
@@ -96,8 +165,11 @@ Animation::increaseSpeed()
 void
 Animation::decreaseSpeed()
 {
-    speed--;
-    if(speed < 1) speed = 1;
+    if(speed <= 1)
+        speed /= 2;
+    else
+        speed--;
+    if(speed < MIN_SPEED) speed = MIN_SPEED;
     update();
 }
 
@@ -148,20 +220,6 @@ Animation::keyPressEvent(QKeyEvent *e)
     update();
 }
 
-void Animation::timerEvent(QTimerEvent *)
-{
-    if (!hasData()) return;
-    Q_ASSERT(speed >= 1);  // @todo slower?
-    history_index += speed;
-    if (history_index >= simulation_history->historySize()) {
-        history_index = simulation_history->historySize() - 1;
-        // startBuffering();
-    }
-    for (auto& orbit: orbits)
-        orbit.updateData(history_index);
-    update();
-}
-
 void Animation::initializeLogging()
 {
     connect(logger, SIGNAL(messageLogged(QOpenGLDebugMessage)),
@@ -177,130 +235,32 @@ void Animation::initializeLogging()
     }
 }
 
-void Animation::initializeShaders()
-{
-    try {
-        if (!program.addShaderFromSourceFile(QOpenGLShader::Vertex,
-                                             ":/shaders/vshader.glsl"))
-            throw Exception("Could not compile vertex shader");
-        if (!program.addShaderFromSourceFile(QOpenGLShader::Fragment,
-                                             ":/shaders/fshader.glsl"))
-            throw Exception("Could not compile fragment shader");
-        if (!program.link())
-            throw Exception("Could not link shader pipeline");
-        if (!program.bind())
-            throw Exception("Could not bind shader pipeline");
-    } catch(Exception&) {
-        qDebug() << program.log();
-        throw;
-    }
-}
-
 void Animation::initializeGL()
 {
     initializeLogging();
-    initializeOpenGLFunctions();
-    initializeShaders();
-    sphere.initialize(1.0);
-
-    glClearColor(0, 0, 0, 1);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_MULTISAMPLE);
-    glEnable(GL_BLEND);
-
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glLineWidth(2);
-
-    printGlErrors();
+    renderer.initialize();
 }
 
 void Animation::resizeGL(int w, int h)
 {
-    qreal aspect = qreal(w) / qreal(h ? h : 1);
-    const qreal zNear = 1.0, zFar = 1024.0, fov = 45.0;
-    projection.setToIdentity();
-    projection.perspective(fov, aspect, zNear, zFar);
+    renderer.resize(w, h);
 }
 
 void Animation::paintGL()
 {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    if (!hasData()) return;
-
-    QMatrix4x4 view;
-    view.translate(0.0, 0.0, -3.0);
-    view.translate(view_translation);
-    view.rotate(view_rotation);
-    view.scale(view_scale);
-
-    Q_ASSERT(universe.size() == simulation_history->universeSize());
-    program.setUniformValue("color", settings.body_color);
-    program.setUniformValue("use_lights", true);
-    for(unsigned i = 0; i < universe.size(); i++) {
-        const auto& body = universe[i];
-        QMatrix4x4 model;
-        model.translate(simulation_history->bodyPosition(i, history_index));
-        model.scale(body.radius
-                    * body.visible_size_multiplier
-                    * settings.visible_size_multiplier);
-        program.setUniformValue("mvp_matrix", projection * view * model);
-        sphere.draw(&program);
-    }
-    program.setUniformValue("color", settings.orbit_color);
-    program.setUniformValue("use_lights", false);
-    for(unsigned i = 0; i < universe.size(); i++) {
-        QMatrix4x4 model;
-        program.setUniformValue("mvp_matrix", projection * view * model);
-        orbits[i].draw(&program, history_index);
-    }
-    printGlErrors();
-}
-
-////////////////////////////////////////////////////////////////////////////////
-float
-Animation::computeUniverseRadius()
-{
-    float max = 0;
-    for (const auto& body: universe) {
-        float distance = abs(body.position);
-        if(distance > max) max = distance;
-    }
-    Q_ASSERT(max > 0);
-    return max;
-}
-
-
-void Animation::printGlErrors()
-{
-    GLenum error = GL_NO_ERROR;
-    do {
-        error = glGetError();
-        if (error != GL_NO_ERROR) {
-            QString s = glErrorToString(error);
-            qDebug() << "OpenGL Error:" << s;
-        }
-    } while (error != GL_NO_ERROR);
+    const double frame_time =
+        frame_timer.isValid() ? frame_timer.nsecsElapsed() / 1e6 : 0;
+    frame_timer.start();
+    renderer.paint(history_position, view_translation, view_rotation,
+                   view_scale);
+    statistics = renderer.statistics();
+    statistics.cpu_time = frame_timer.nsecsElapsed() / 1e6;
+    statistics.frame_time = frame_time;
+    emit frameDrawn();
 }
 
-QString Animation::glErrorToString(GLenum error_code)
+physics::DOUBLE
+Animation::drawnTime()
 {
-    switch(error_code) {
-    case GL_NO_ERROR:
-        return "No error";
-    case GL_INVALID_ENUM:
-        return "Invalid enumerant";
-    case GL_INVALID_VALUE:
-        return "Invalid value";
-    case GL_INVALID_OPERATION:
-        return "Invalid operation";
-    case GL_STACK_OVERFLOW:
-        return "Stack overflow";
-    case GL_STACK_UNDERFLOW:
-        return "Stack underflow";
-    case GL_OUT_OF_MEMORY:
-        return "Out of memory";
-    default:
-        return "Unknown error";
-    }
+    return renderer.timeAt(history_position);
 }
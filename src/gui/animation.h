@@ -25,26 +25,28 @@
 
 
 #include <memory>
-#include <vector>
 #include <QOpenGLWidget>
-#include <QOpenGLFunctions>
-#include <QOpenGLShaderProgram>
 #include <QOpenGLDebugLogger>
-#include <QBasicTimer>
+#include <QElapsedTimer>
+#include <QVector2D>
 #include <QVector3D>
+#include <QQuaternion>
 
 #include "physics/universemodel.h"
 #include "simulationhistory.h"
 #include "projectparser.h"
 #include "gui/animationstate.h"
-#include "gui/sphere.h"
-#include "gui/orbit.h"
+#include "gui/renderer.h"
+#include "gui/framestatistics.h"
 
 /**
  * OpenGL animation of the bodies movement.
- * Updates itself using a timer every few miliseconds.
+ *
+ * While playing, a new frame is drawn as soon as the previous one is swapped
+ * to the screen. Every frame moves the animation by the real time that passed
+ * since the last one, multiplied by the playback rate.
  */
-class Animation : public QOpenGLWidget, protected QOpenGLFunctions
+class Animation : public QOpenGLWidget
 {
     Q_OBJECT
 
@@ -62,6 +64,18 @@ public:
         return history_index;
     }
 
+    /// Get the simulation time (in seconds) that is currently being drawn.
+    physics::DOUBLE drawnTime();
+
+    /// How many seconds of the simulation time are played in one second of
+    /// real time.
+    double playbackRate();
+
+    /// Measurements of the last drawn frame.
+    const FrameStatistics& frameStatistics() const {
+        return statistics;
+    }
+
 
 signals:
     /** Emited when buffering has started or stopped. Buffering happens when
@@ -70,6 +84,16 @@ signals:
      */
     void stateChanged(AnimationState state);
 
+    /// Emitted after every drawn frame, see Animation::frameStatistics.
+    void frameDrawn();
+
+    /** Emitted when the playing animation moves forward, so that the
+     * simulation can stay far enough ahead of it.
+     * @param time: simulation time that will be drawn, in seconds
+     * @param rate: see Animation::playbackRate
+     */
+    void playbackAdvanced(physics::DOUBLE time, double rate);
+
 public slots:
     /// Start the animation if `run` is set to true, stop otherwise.
     void startOrStop(bool start);
@@ -77,22 +101,27 @@ public slots:
     /// Reads simulation history from beginning, resets opengl camera position
     void reset();
 
+    /// Jump to the simulation time (in seconds) in the simulation history.
+    void seek(physics::DOUBLE time);
+
     /// Move trough the simulation history faster.
     void increaseSpeed();
-    /// Move trough the simulation history slower.
-    /// @todo 0.5 speed? interpolation? speed = 0?
+    /// Move trough the simulation history slower. Below speed 1, the speed is
+    /// halved and the positions between saved states are interpolated.
     void decreaseSpeed();
 
     void onMessageLogged(QOpenGLDebugMessage message);
 
+private slots:
+    /// Move the playing animation forward and schedule the next frame.
+    void advance();
+
 protected:
     void mousePressEvent(QMouseEvent *e) override;
     void mouseMoveEvent(QMouseEvent *e) override;
     void keyPressEvent(QKeyEvent *e) override;
-    void timerEvent(QTimerEvent *e) override;
 
     void initializeLogging();
-    void initializeShaders();
     void initializeGL() override;
     void resizeGL(int w, int h) override;
     void paintGL() override;
@@ -101,37 +130,36 @@ protected:
     bool hasData() {
         return !simulation_history->empty();
     }
-    float computeUniverseRadius();
-    void printGlErrors();
-    QString glErrorToString(GLenum error_code);
 private:
-    QBasicTimer timer;
     QOpenGLDebugLogger *logger;
-    QOpenGLShaderProgram program;
-    QMatrix4x4 projection;
+    /// Does all the drawing, the widget only handles the input and timing.
+    Renderer renderer;
+    FrameStatistics statistics;
+    /// Started at the beginning of every frame.
+    QElapsedTimer frame_timer;
 
     /// Data to be animated.
     const std::shared_ptr<SimulationHistory> simulation_history;
     /// Index in the simulation_history that is currently being drawn
     unsigned history_index = 0;
-
-    /// Local copy of the universe info (used to get the names, colors, etc.)
-    physics::UniverseModel universe;
-
-    parser::ProjectSettings settings;
-
-    /// How fast should it animate (i.e. read the simulation history).
-    int speed = 1;
+    /// Position in the simulation_history including the fraction between
+    /// history_index and the next saved state, used with speeds below 1.
+    double history_position = 0;
+    /// Simulation time (in seconds) of the playback, history_position is
+    /// derived from it.
+    physics::DOUBLE playback_time = 0;
+
+    bool playing = false;
+    /// Measures the real time between advancing the playback.
+    QElapsedTimer playback_clock;
+    /// How fast should it animate, relative to STATES_PER_SECOND.
+    float speed = 1;
     /// How much should the view matrix be scaled.
     float view_scale = 1.0;
     QVector3D view_translation;
     QQuaternion view_rotation;
 
     QVector2D mouse_press_position;
-
-    // models
-    Sphere sphere;
-    std::vector<Orbit> orbits;
 };
 
 #endif  // __ANIMATION_H__
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+
+/**
+ * @file
+ */
+#ifndef __FRAME_STATISTICS_H__
+#define __FRAME_STATISTICS_H__
+
+/// Parts of a frame whose GPU time is measured separately.
+enum RenderPass {
+    POINTS_PASS,
+    SPHERES_PASS,
+    TRAJECTORIES_PASS,
+    RENDER_PASS_COUNT
+};
+
+/// Measurements of a single drawn frame, to find out what limits the
+/// animation.
+struct FrameStatistics {
+    /// Time since the previous frame started, in milliseconds.
+    double frame_time = 0;
+    /// Time spent on the CPU submitting the frame, in milliseconds.
+    double cpu_time = 0;
+    /// Number of OpenGL draw calls in the frame.
+    unsigned draw_calls = 0;
+    /// How many bytes were written into the trajectory buffers since the
+    /// previous frame.
+    unsigned long uploaded_bytes = 0;
+    /** GPU time of each RenderPass in milliseconds, measured with timer
+     * queries. The results arrive a few frames late, so these are the latest
+     * available ones. Negative if the timer queries aren't supported.
+     */
+    double gpu_time[RENDER_PASS_COUNT] = {-1, -1, -1};
+};
+
+#endif  // __FRAME_STATISTICS_H__
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+
+/**
+ * @file
+ */
+#include "gui/framewriter.h"
+
+#include <QDir>
+#include <QMutexLocker>
+#include "exceptions.h"
+
+/// How many frames can wait in the queue before FrameWriter::write blocks.
+const unsigned MAX_QUEUED_FRAMES = 8;
+
+
+FrameWriter::FrameWriter(const QString& path, Format format, QObject *parent)
+    : QThread(parent), path(path), format(format)
+{
+    if (format == PNG && !QDir().mkpath(path))
+        throw Exception("Could not create the directory " + path);
+    if (format == RAW_VIDEO) {
+        raw_file.setFileName(path);
+        if (!raw_file.open(QIODevice::WriteOnly))
+            throw Exception("Could not open " + path + " for writing");
+    }
+}
+
+FrameWriter::~FrameWriter()
+{
+    {
+        QMutexLocker lock(&mutex);
+        finishing = true;
+        queue_not_empty.wakeAll();
+    }
+    wait();
+}
+
+void
+FrameWriter::write(const QImage& frame)
+{
+    QMutexLocker lock(&mutex);
+    while (queue.size() >= MAX_QUEUED_FRAMES && error.isEmpty())
+        queue_not_full.wait(&mutex);
+    if (!error.isEmpty())
+        throw Exception("Writing frames failed - " + error);
+    queue.push_back(frame);
+    queue_not_empty.wakeOne();
+}
+
+void
+FrameWriter::finish()
+{
+    {
+        QMutexLocker lock(&mutex);
+        finishing = true;
+        queue_not_empty.wakeAll();
+    }
+    wait();
+    if (raw_file.isOpen() && !raw_file.flush())
+        error = "could not write into " + path;
+    if (!error.isEmpty())
+        throw Exception("Writing frames failed - " + error);
+}
+
+unsigned
+FrameWriter::writtenFrames()
+{
+    QMutexLocker lock(&mutex);
+    return written;
+}
+
+void
+FrameWriter::run()
+{
+    while (true) {
+        QImage frame;
+        unsigned index;
+        {
+            QMutexLocker lock(&mutex);
+            while (queue.empty() && !finishing)
+                queue_not_empty.wait(&mutex);
+            if (queue.empty() || !error.isEmpty())
+                return;
+            frame = queue.front();
+            queue.pop_front();
+            index = written;
+            queue_not_full.wakeOne();
+        }
+
+        // the slow part runs without the lock
+        const QString message = writeFrame(frame, index);
+
+        QMutexLocker lock(&mutex);
+        if (!message.isEmpty()) {
+            error = message;
+            queue.clear();
+            queue_not_full.wakeAll();
+            return;
+        }
+        written++;
+    }
+}
+
+QString
+FrameWriter::writeFrame(const QImage& frame, unsigned index)
+{
+    // OpenGL has the origin in the bottom left corner
+    const QImage image = frame.mirrored();
+    if (format == PNG) {
+        const QString name = QString("%1/frame-%2.png")
+                             .arg(path).arg(index, 6, 10, QChar('0'));
+        if (!image.save(name, "PNG"))
+            return "could not save " + name;
+    } else {
+        const qint64 size = image.bytesPerLine() * image.height();
+        if (raw_file.write(reinterpret_cast<const char*>(image.constBits()),
+                           size) != size)
+            return "could not write into " + path;
+    }
+    return QString();
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+
+/**
+ * @file
+ */
+#ifndef __FRAME_WRITER_H__
+#define __FRAME_WRITER_H__
+
+#include <deque>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QImage>
+#include <QFile>
+#include <QString>
+
+/** Write rendered frames to disk in a separate thread, so that encoding and
+ * disk access overlap with rendering the next frames.
+ *
+ * The frames are queued; if the writer falls behind, FrameWriter::write blocks
+ * until there is space in the queue again.
+ */
+class FrameWriter : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Format {
+        /// One PNG image per frame, `frame-000000.png` etc. in a directory.
+        PNG,
+        /// All frames in one file as raw RGBA pixels, without any header
+        /// (e.g. `ffmpeg -f rawvideo -pix_fmt rgba -s WxH -i file ...`).
+        RAW_VIDEO
+    };
+
+    /// @param path: directory for PNG, file name for RAW_VIDEO
+    FrameWriter(const QString& path, Format format, QObject *parent = nullptr);
+    ~FrameWriter();
+
+    /** Queue the frame for writing. The image has to be stored bottom-up, the
+     * way OpenGL reads it.
+     * @exception Exception if writing some of the previous frames failed
+     */
+    void write(const QImage& frame);
+
+    /** Write all the queued frames and stop the thread.
+     * @exception Exception if writing some of the frames failed
+     */
+    void finish();
+
+    /// How many frames were written so far.
+    unsigned writtenFrames();
+
+protected:
+    void run() override;
+
+private:
+    /// Write one frame, returns an error message or an empty string.
+    QString writeFrame(const QImage& frame, unsigned index);
+
+    QString path;
+    Format format;
+    /// Used only with RAW_VIDEO, opened for the whole lifetime.
+    QFile raw_file;
+
+    QMutex mutex;
+    QWaitCondition queue_not_empty;
+    QWaitCondition queue_not_full;
+    std::deque<QImage> queue;
+    bool finishing = false;
+    unsigned written = 0;
+    /// First error that happened in the writer thread.
+    QString error;
+};
+
+#endif  // __FRAME_WRITER_H__
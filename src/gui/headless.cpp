@@ -0,0 +1,149 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+
+/**
+ * @file
+ */
+#include "gui/headless.h"
+
+#include <cmath>
+#include <memory>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QDebug>
+#include "gui/offscreenrenderer.h"
+#include "projectparser.h"
+#include "simulation.h"
+#include "simulationhistory.h"
+#include "exceptions.h"
+
+
+bool
+parseHeadlessOptions(const QCoreApplication& app, HeadlessOptions *options)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Animate paths of celestial bodies.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {   "render",
+            QCoreApplication::translate("main",
+            "Don't open any window, render the animation into files instead."
+            " Works without a display, e.g. with QT_QPA_PLATFORM=offscreen"
+            " (and LIBGL_ALWAYS_SOFTWARE=1 for Mesa's software rasterizer)."),
+            QCoreApplication::translate("main", "output")
+        },
+        {   {"f", "file"},
+            QCoreApplication::translate("main",
+            "Input XML file with universe model, required with --render."),
+            QCoreApplication::translate("main", "file")
+        },
+        {   "format",
+            QCoreApplication::translate("main",
+            "'png' for a directory of images (default), or 'raw' for one"
+            " file of RGBA frames."),
+            QCoreApplication::translate("main", "format")
+        },
+        {   "frames",
+            QCoreApplication::translate("main",
+            "Number of rendered frames. Default is ")
+            + QString::number(options->frames) + ".",
+            QCoreApplication::translate("main", "count")
+        },
+        {   "size",
+            QCoreApplication::translate("main",
+            "Size of the frames. Default is 1280x720."),
+            QCoreApplication::translate("main", "WxH")
+        },
+        {   "speed",
+            QCoreApplication::translate("main",
+            "Saved simulation states per frame (floating-point). Default is 1."),
+            QCoreApplication::translate("main", "states")
+        }
+    });
+    parser.process(app);
+    if(!parser.isSet("render"))
+        return false;
+
+    options->output = parser.value("render");
+    options->file_name = parser.value("file");
+    if(options->file_name.isEmpty())
+        throw Exception("No input file name specified.");
+
+    if(parser.isSet("format")) {
+        const QString format = parser.value("format");
+        if(format == "png")
+            options->format = FrameWriter::PNG;
+        else if(format == "raw")
+            options->format = FrameWriter::RAW_VIDEO;
+        else
+            throw Exception("Unknown output format " + format);
+    }
+    bool ok = true;
+    if(parser.isSet("frames"))
+        options->frames = parser.value("frames").toUInt(&ok);
+    if(!ok || options->frames == 0)
+        throw Exception("Invalid number of frames.");
+    if(parser.isSet("speed"))
+        options->speed = parser.value("speed").toDouble(&ok);
+    if(!ok || options->speed <= 0)
+        throw Exception("Invalid speed.");
+    if(parser.isSet("size")) {
+        const QStringList size = parser.value("size").split('x');
+        bool ok_height = false;
+        if(size.size() == 2) {
+            options->size = QSize(size[0].toInt(&ok), size[1].toInt(&ok_height));
+        }
+        if(size.size() != 2 || !ok || !ok_height || options->size.isEmpty())
+            throw Exception("Invalid size, expected e.g. 1280x720.");
+    }
+    return true;
+}
+
+void
+renderHeadless(const HeadlessOptions& options)
+{
+    parser::ProjectParser project(options.file_name);
+    const auto settings = project.getSettings();
+    const auto universe = project.getUniverseModel();
+
+    auto history = std::make_shared<SimulationHistory>();
+    Simulation simulation(nullptr, history);
+    simulation.loadUniverse(universe, settings);
+
+    FrameWriter writer(options.output, options.format);
+    writer.start();
+    OffscreenRenderer renderer(history, options.size, &writer);
+    renderer.loadUniverse(universe, settings);
+
+    QElapsedTimer timer;
+    timer.start();
+    for(unsigned i = 0; i < options.frames; i++) {
+        const double position = i * options.speed;
+        // the state after the drawn one is needed for the interpolation, so
+        // the history has to contain both
+        simulation.computeUntil(unsigned(std::floor(position)) + 2);
+        renderer.render(position);
+    }
+    renderer.finish();
+    writer.finish();
+    qDebug() << "Rendered" << writer.writtenFrames() << "frames in"
+             << timer.elapsed() << "ms";
+}
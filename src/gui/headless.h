@@ -0,0 +1,63 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+
+/**
+ * @file
+ * Rendering the animation into files without any window.
+ */
+#ifndef __HEADLESS_H__
+#define __HEADLESS_H__
+
+#include <QString>
+#include <QSize>
+#include "gui/framewriter.h"
+
+class QCoreApplication;
+
+/// Parameters of the headless rendering, given on the command line.
+struct HeadlessOptions {
+    /// Input XML file with the universe model.
+    QString file_name;
+    /// Directory for the images or a file for the raw video.
+    QString output;
+    FrameWriter::Format format = FrameWriter::PNG;
+    /// Size of the frames in pixels.
+    QSize size = QSize(1280, 720);
+    /// How many frames to render.
+    unsigned frames = 600;
+    /// How many saved states of the simulation history to move in one frame.
+    double speed = 1;
+};
+
+/** Parse the command line of the GUI.
+ * @return true if the headless rendering was requested, the options are then
+ *      filled in
+ * @exception Exception if the headless options are invalid
+ */
+bool parseHeadlessOptions(const QCoreApplication& app,
+                          HeadlessOptions *options);
+
+/** Compute the simulation and render all the frames into files, without
+ * showing any window.
+ * @exception Exception on any error
+ */
+void renderHeadless(const HeadlessOptions& options);
+
+#endif  // __HEADLESS_H__
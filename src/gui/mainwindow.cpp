@@ -28,6 +28,7 @@
 #include <QTimer>
 #include "gui/animation.h"
 #include "gui/animationstate.h"
+#include "gui/framestatistics.h"
 #include "algorithms/types.h"
 #include "exceptions.h"
 #include "simulation.h"
@@ -35,6 +36,8 @@
 
 /// How long to display a message in the status bar
 const unsigned STATUS_MSG_TIMEOUT = 10000;
+/// How often to show the performance measurements, in milliseconds
+const int STATISTICS_INTERVAL = 500;
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
@@ -52,6 +55,12 @@ MainWindow::MainWindow(QWidget *parent)
     animation->setFocusPolicy(Qt::StrongFocus);
     animation->setFocus();
 
+    statistics_label = new QLabel(this);
+    statusBar()->addPermanentWidget(statistics_label);
+    statistics_timer = new QTimer(this);
+    statistics_timer->start(STATISTICS_INTERVAL);
+    steps_clock.start();
+
     ui->playButton->setEnabled(false);
     populateAlgorithmComboBox();
     connectActions();
@@ -100,6 +109,8 @@ MainWindow::connectActions()
             animation, SLOT(startOrStop(bool)));
     connect(animation, SIGNAL(stateChanged(AnimationState)),
             simulation, SLOT(changeComputationIntensity(AnimationState)));
+    connect(animation, SIGNAL(playbackAdvanced(physics::DOUBLE, double)),
+            simulation, SLOT(prefetch(physics::DOUBLE, double)));
 
     connect(ui->forwardButton, SIGNAL(clicked()),
             animation, SLOT(increaseSpeed()));
@@ -111,6 +122,16 @@ MainWindow::connectActions()
             this, SLOT(open()));
     connect(ui->actionQuit, SIGNAL(triggered()),
             this, SLOT(close()));
+    connect(ui->actionGoToTime, SIGNAL(triggered()),
+            this, SLOT(goToTime()));
+    connect(ui->actionRecordStatistics, SIGNAL(toggled(bool)),
+            this, SLOT(recordStatistics(bool)));
+
+    // instrumentation
+    connect(statistics_timer, SIGNAL(timeout()),
+            this, SLOT(updateStatistics()));
+    connect(animation, SIGNAL(frameDrawn()),
+            this, SLOT(recordFrame()));
 
     // algorithm changes
     connect(ui->setAlgorithmButton, SIGNAL(clicked()),
@@ -133,6 +154,110 @@ MainWindow::changeAlgorithm()
                              animation->drawnSimulationHistoryIndex());
 }
 
+void
+MainWindow::goToTime()
+{
+    if (simulation_history->empty()) return;
+    const double SECONDS_IN_DAY = 60*60*24;
+    const double last = simulation_history->savedTime(
+                            simulation_history->historySize() - 1);
+    bool ok = false;
+    double days = QInputDialog::getDouble(
+                      this, tr("Go to time"),
+                      tr("Simulation time in days:"),
+                      animation->drawnTime() / SECONDS_IN_DAY,
+                      0, last / SECONDS_IN_DAY, 2, &ok);
+    if (ok)
+        animation->seek(days * SECONDS_IN_DAY);
+}
+
+unsigned
+MainWindow::bufferingLead()
+{
+    if (simulation_history->empty()) return 0;
+    return simulation_history->historySize() - 1
+           - animation->drawnSimulationHistoryIndex();
+}
+
+void
+MainWindow::updateStatistics()
+{
+    const unsigned long steps = simulation->computedSteps();
+    steps_per_second = (steps - last_computed_steps)
+                       / (steps_clock.restart() / 1000.0);
+    last_computed_steps = steps;
+
+    const FrameStatistics& frame = animation->frameStatistics();
+    QString text = tr("frame %1 ms (CPU %2 ms), %3 draw calls, %4 kB uploaded")
+                   .arg(frame.frame_time, 0, 'f', 1)
+                   .arg(frame.cpu_time, 0, 'f', 1)
+                   .arg(frame.draw_calls)
+                   .arg(frame.uploaded_bytes / 1024.0, 0, 'f', 1);
+    if (frame.gpu_time[0] >= 0) {
+        text += tr(" | GPU points %1, spheres %2, trajectories %3 ms")
+                .arg(frame.gpu_time[POINTS_PASS], 0, 'f', 2)
+                .arg(frame.gpu_time[SPHERES_PASS], 0, 'f', 2)
+                .arg(frame.gpu_time[TRAJECTORIES_PASS], 0, 'f', 2);
+    }
+    text += tr(" | %1 steps/s | lead %2 states")
+            .arg(steps_per_second, 0, 'f', 0)
+            .arg(bufferingLead());
+    statistics_label->setText(text);
+}
+
+void
+MainWindow::recordFrame()
+{
+    if (!statistics_file.isOpen()) return;
+    const FrameStatistics& frame = animation->frameStatistics();
+    statistics_stream << recording_clock.elapsed() << ","
+                      << frame.frame_time << ","
+                      << frame.cpu_time << ","
+                      << frame.draw_calls << ","
+                      << frame.uploaded_bytes << ","
+                      << frame.gpu_time[POINTS_PASS] << ","
+                      << frame.gpu_time[SPHERES_PASS] << ","
+                      << frame.gpu_time[TRAJECTORIES_PASS] << ","
+                      << steps_per_second << ","
+                      << bufferingLead() << "\n";
+}
+
+void
+MainWindow::recordStatistics(bool start)
+{
+    if (!start) {
+        if (statistics_file.isOpen()) {
+            statistics_stream.flush();
+            statistics_file.close();
+            statusBar()->showMessage(tr("Statistics saved into ")
+                                     + statistics_file.fileName(),
+                                     STATUS_MSG_TIMEOUT);
+        }
+        return;
+    }
+    const QString fileName =
+        QFileDialog::getSaveFileName(this, tr("Record statistics"),
+                                     "statistics.csv",
+                                     tr("CSV Files (*.csv)"));
+    statistics_file.setFileName(fileName);
+    if (fileName.isEmpty()
+            || !statistics_file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        if (!fileName.isEmpty()) {
+            QMessageBox::warning(this, tr("Failed to record statistics"),
+                                 tr("Could not open ") + fileName);
+        }
+        // don't leave the action checked
+        ui->actionRecordStatistics->setChecked(false);
+        return;
+    }
+    statistics_stream.setDevice(&statistics_file);
+    statistics_stream << "wall_time_ms,frame_time_ms,cpu_time_ms,draw_calls,"
+                         "uploaded_bytes,gpu_points_ms,gpu_spheres_ms,"
+                         "gpu_trajectories_ms,steps_per_second,"
+                         "buffering_lead_states\n";
+    recording_clock.start();
+}
+
 /**
  * Hides the title bar on the algorithm selection dock and the play/pause dock.
  * Looks nicer.
@@ -27,12 +27,17 @@
 
 #include <memory>
 #include <QtWidgets/QMainWindow>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
 
 #include "ui_mainwindow.h"
 #include "simulationhistory.h"
 
 class Simulation;
 class Animation;
+class QLabel;
+class QTimer;
 
 #define WINDOW_TITLE "NSim N-body Simulator"
 #define SETTINGS_FILE "settings.xml"
@@ -58,6 +63,19 @@ private slots:
 
     void changeAlgorithm();
 
+    /// Ask for a simulation time and move the animation there.
+    void goToTime();
+
+    /// Show the latest performance measurements in the status bar.
+    void updateStatistics();
+
+    /// Write the measurements of the last frame into the CSV file, if
+    /// recording.
+    void recordFrame();
+
+    /// Ask for a CSV file and start recording into it, or stop recording.
+    void recordStatistics(bool start);
+
 private:
     Q_DISABLE_COPY(MainWindow)
 
@@ -69,6 +87,9 @@ private:
 
     void populateAlgorithmComboBox();
 
+    /// How many saved states the simulation is ahead of the animation.
+    unsigned bufferingLead();
+
     /// user interface created with Qt Designer
     Ui::MainWindow *ui;
 
@@ -79,6 +100,18 @@ private:
     Animation *animation;
 
     std::shared_ptr<SimulationHistory> simulation_history;
+
+    /// Permanent part of the status bar with performance measurements.
+    QLabel *statistics_label;
+    QTimer *statistics_timer;
+    /// Time since the simulation steps were last counted.
+    QElapsedTimer steps_clock;
+    unsigned long last_computed_steps = 0;
+    double steps_per_second = 0;
+    /// Time since the recording started.
+    QElapsedTimer recording_clock;
+    QFile statistics_file;
+    QTextStream statistics_stream;
 };
 
 #endif  // MAINWINDOW_H
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+
+/**
+ * @file
+ */
+#include "gui/multidraw.h"
+
+#include <QOpenGLContext>
+
+
+void
+MultiDraw::initialize()
+{
+    initializeOpenGLFunctions();
+    multi_draw_arrays = reinterpret_cast<MultiDrawArrays>(
+        QOpenGLContext::currentContext()->getProcAddress("glMultiDrawArrays"));
+}
+
+unsigned
+MultiDraw::draw(GLenum mode, const std::vector<GLint>& firsts,
+                const std::vector<GLsizei>& counts)
+{
+    Q_ASSERT(firsts.size() == counts.size());
+    if (firsts.empty()) return 0;
+    if (multi_draw_arrays) {
+        multi_draw_arrays(mode, firsts.data(), counts.data(), firsts.size());
+        return 1;
+    }
+    for (unsigned i = 0; i < firsts.size(); i++)
+        glDrawArrays(mode, firsts[i], counts[i]);
+    return firsts.size();
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+
+/**
+ * @file
+ */
+#ifndef __MULTI_DRAW_H__
+#define __MULTI_DRAW_H__
+
+#include <vector>
+#include <QOpenGLFunctions>
+
+
+/** Draw several ranges of vertices from the currently set attribute buffers
+ * with a single glMultiDrawArrays call, or one glDrawArrays per range if it's
+ * not available (e.g. in OpenGL ES).
+ */
+class MultiDraw : protected QOpenGLFunctions
+{
+public:
+    MultiDraw() = default;
+
+    /** Call this in initializeGL() or the equivalent - it assumes that the
+     * OpenGL context is bound, so it has to be separate from the constructor.
+     */
+    void initialize();
+
+    /// Whether glMultiDrawArrays was found in the context.
+    bool supported() const {
+        return multi_draw_arrays != nullptr;
+    }
+
+    /** Draw the ranges given by their first vertices and vertex counts.
+     * @return number of the issued draw calls
+     */
+    unsigned draw(GLenum mode, const std::vector<GLint>& firsts,
+              const std::vector<GLsizei>& counts);
+
+private:
+    typedef void (QOPENGLF_APIENTRYP MultiDrawArrays)(GLenum mode,
+            const GLint *first, const GLsizei *count, GLsizei drawcount);
+
+    /// Not part of QOpenGLFunctions, so it has to be resolved separately.
+    MultiDrawArrays multi_draw_arrays = nullptr;
+};
+
+#endif  // __MULTI_DRAW_H__
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+
+/**
+ * @file
+ */
+#include "gui/offscreenrenderer.h"
+
+#include <cmath>
+#include <QImage>
+#include <QDebug>
+#include "exceptions.h"
+
+
+OffscreenRenderer::OffscreenRenderer(
+    std::shared_ptr<SimulationHistory> const history,
+    const QSize& size, FrameWriter *writer)
+    : size(size), writer(writer),
+      pixel_buffers{QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer),
+                    QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer)}
+{
+    Q_ASSERT(writer != nullptr);
+    if (size.isEmpty())
+        throw Exception("Invalid size of the rendered frames");
+
+    QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+    // there is nobody to read the messages
+    format.setOption(QSurfaceFormat::DebugContext, false);
+    context.setFormat(format);
+    if (!context.create())
+        throw Exception("Could not create an OpenGL context");
+    surface.setFormat(context.format());
+    surface.create();
+    if (!surface.isValid())
+        throw Exception("Could not create an offscreen surface");
+    makeCurrent();
+    initializeOpenGLFunctions();
+    qDebug() << "Offscreen rendering with" << context.format();
+
+    QOpenGLFramebufferObjectFormat fbo_format;
+    fbo_format.setAttachment(QOpenGLFramebufferObject::Depth);
+    // -1 means the default, i.e. no multisampling
+    fbo_format.setSamples(qMax(0, context.format().samples()));
+    framebuffer.reset(new QOpenGLFramebufferObject(size, fbo_format));
+    if (!framebuffer->isValid() && fbo_format.samples() > 0) {
+        qDebug("Multisampled framebuffer not supported, using one sample");
+        fbo_format.setSamples(0);
+        framebuffer.reset(new QOpenGLFramebufferObject(size, fbo_format));
+    }
+    if (!framebuffer->isValid())
+        throw Exception("Could not create a framebuffer object");
+    if (framebuffer->format().samples() > 0)
+        resolved_framebuffer.reset(new QOpenGLFramebufferObject(size));
+
+    for (auto& buffer: pixel_buffers) {
+        buffer.create();
+        buffer.setUsagePattern(QOpenGLBuffer::StreamRead);
+        buffer.bind();
+        buffer.allocate(size.width() * size.height() * 4);
+        buffer.release();
+    }
+
+    renderer.reset(new Renderer(history));
+    framebuffer->bind();
+    renderer->initialize();
+    renderer->resize(size.width(), size.height());
+}
+
+OffscreenRenderer::~OffscreenRenderer()
+{
+    // the buffers have to be deleted with the context current
+    makeCurrent();
+    renderer.reset();
+    framebuffer.reset();
+    resolved_framebuffer.reset();
+    for (auto& buffer: pixel_buffers)
+        buffer.destroy();
+    context.doneCurrent();
+}
+
+void
+OffscreenRenderer::makeCurrent()
+{
+    if (!context.makeCurrent(&surface))
+        throw Exception("Could not make the OpenGL context current");
+}
+
+void
+OffscreenRenderer::loadUniverse(physics::UniverseModel u,
+                                parser::ProjectSettings p)
+{
+    makeCurrent();
+    renderer->loadUniverse(u, p);
+    view_scale = 1.0/renderer->universeRadius();
+    frame = 0;
+}
+
+void
+OffscreenRenderer::render(double history_position)
+{
+    makeCurrent();
+    framebuffer->bind();
+    glViewport(0, 0, size.width(), size.height());
+    renderer->updateTrajectories(unsigned(std::floor(history_position)), 0);
+    renderer->paint(history_position, QVector3D(), QQuaternion(), view_scale);
+
+    QOpenGLFramebufferObject *source = framebuffer.get();
+    if (resolved_framebuffer) {
+        QOpenGLFramebufferObject::blitFramebuffer(resolved_framebuffer.get(),
+                                                  framebuffer.get());
+        source = resolved_framebuffer.get();
+    }
+    // start copying the frame into the pixel buffer, this returns immediately
+    const unsigned current = frame % 2;
+    source->bind();
+    pixel_buffers[current].bind();
+    glReadPixels(0, 0, size.width(), size.height(), GL_RGBA,
+                 GL_UNSIGNED_BYTE, nullptr);
+    pixel_buffers[current].release();
+    pending[current] = true;
+
+    // the previous frame had the whole time of this one to finish copying
+    const unsigned previous = (frame + 1) % 2;
+    if (pending[previous])
+        readBack(previous);
+    frame++;
+}
+
+void
+OffscreenRenderer::finish()
+{
+    makeCurrent();
+    // in the order in which they were rendered
+    for (unsigned i = 0; i < 2; i++) {
+        const unsigned buffer = (frame + i) % 2;
+        if (pending[buffer])
+            readBack(buffer);
+    }
+}
+
+void
+OffscreenRenderer::readBack(unsigned buffer)
+{
+    Q_ASSERT(pending[buffer]);
+    auto& pixel_buffer = pixel_buffers[buffer];
+    pixel_buffer.bind();
+    const void *data = pixel_buffer.mapRange(0, pixel_buffer.size(),
+                                             QOpenGLBuffer::RangeRead);
+    if (data == nullptr) {
+        pixel_buffer.release();
+        throw Exception("Could not map the pixel buffer");
+    }
+    // copy it, the buffer will be reused for the next frames
+    const QImage image = QImage(static_cast<const uchar*>(data),
+                                size.width(), size.height(),
+                                QImage::Format_RGBA8888).copy();
+    pixel_buffer.unmap();
+    pixel_buffer.release();
+    pending[buffer] = false;
+    writer->write(image);
+}
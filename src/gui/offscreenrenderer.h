@@ -0,0 +1,98 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+
+/**
+ * @file
+ */
+#ifndef __OFFSCREEN_RENDERER_H__
+#define __OFFSCREEN_RENDERER_H__
+
+#include <memory>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLBuffer>
+#include <QOffscreenSurface>
+#include <QSize>
+
+#include "physics/universemodel.h"
+#include "simulationhistory.h"
+#include "projectparser.h"
+#include "gui/renderer.h"
+#include "gui/framewriter.h"
+
+/** Render the animation without any window, into a framebuffer object, and
+ * pass the frames to a FrameWriter.
+ *
+ * The frames are read back asynchronously through two pixel buffer objects:
+ * while the GPU copies the frame N into one of them, the frame N-1 is taken
+ * from the other one, so the readback overlaps with drawing the next frame.
+ *
+ * It needs only a QOffscreenSurface, so it works e.g. with the `offscreen`
+ * platform plugin and Mesa's software rasterizer on machines without a
+ * display.
+ */
+class OffscreenRenderer : protected QOpenGLExtraFunctions
+{
+public:
+    /** Create the OpenGL context and the buffers.
+     * @param writer: where the frames will be passed, has to be running
+     * @exception Exception if the context or the framebuffer can't be created
+     */
+    OffscreenRenderer(std::shared_ptr<SimulationHistory> const history,
+                      const QSize& size, FrameWriter *writer);
+    ~OffscreenRenderer();
+
+    /// Load new universe informations and reset the camera.
+    void loadUniverse(physics::UniverseModel u, parser::ProjectSettings p);
+
+    /** Draw the frame at the position in the history and start reading it
+     * back. The previous frame is passed to the writer.
+     */
+    void render(double history_position);
+
+    /// Pass the last frame to the writer.
+    void finish();
+
+private:
+    Q_DISABLE_COPY(OffscreenRenderer)
+
+    void makeCurrent();
+    /// Map the pixel buffer and pass its content to the writer.
+    void readBack(unsigned buffer);
+
+    QOpenGLContext context;
+    QOffscreenSurface surface;
+    QSize size;
+    FrameWriter *writer;
+    /// The frames are drawn here, multisampled if the format allows it.
+    std::unique_ptr<QOpenGLFramebufferObject> framebuffer;
+    /// Resolved multisampled framebuffer, nullptr if it isn't multisampled.
+    std::unique_ptr<QOpenGLFramebufferObject> resolved_framebuffer;
+    QOpenGLBuffer pixel_buffers[2];
+    /// Whether a frame is waiting to be read from the pixel buffer.
+    bool pending[2] = {false, false};
+    unsigned frame = 0;
+
+    std::unique_ptr<Renderer> renderer;
+    float view_scale = 1;
+};
+
+#endif  // __OFFSCREEN_RENDERER_H__
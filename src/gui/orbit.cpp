@@ -23,82 +23,130 @@
 #include "gui/orbit.h"
 
 #include <algorithm>
-#include <QOpenGLShaderProgram>
 
 const unsigned VERTEX_SIZE = 3;
 
 
 Orbit::Orbit(const std::shared_ptr<SimulationHistory> history,
-             const unsigned body_index)
-    : simulation_history(history), body_index(body_index)
+             const unsigned body_index, QOpenGLBuffer *buffer,
+             unsigned offset, unsigned capacity)
+    : vertex_buffer(buffer), simulation_history(history),
+      body_index(body_index), offset(offset), capacity(capacity)
 {
     Q_ASSERT(history != nullptr);
+    Q_ASSERT(buffer != nullptr);
     Q_ASSERT(body_index < history->universeSize());
-    Q_ASSERT(MAX_BUFFER_LENGTH % VERTEX_SIZE == 0);
+    Q_ASSERT(offset % VERTEX_SIZE == 0);
+    Q_ASSERT(capacity % VERTEX_SIZE == 0);
+    Q_ASSERT(capacity >= 2 * VERTEX_SIZE);
 }
 
-void
-Orbit::initialize()
+unsigned
+Orbit::updateData(unsigned until_history_index, unsigned level)
 {
-    initializeOpenGLFunctions();
-    vertex_buffer.create();
-    vertex_buffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
-    vertex_buffer.bind();
-    vertex_buffer.allocate(MAX_BUFFER_LENGTH * sizeof(GLfloat));
-    vertex_buffer.release();
-}
+    if (history_index > until_history_index) return 0;
+    const PositionSpan data =
+        simulation_history->bodyPositions(body_index, level);
+    const unsigned stride = SimulationHistory::levelStride(level);
 
-void
-Orbit::updateData(unsigned until_history_index)
-{
-    if (history_index > until_history_index) return;
-    const auto data = simulation_history->bodyPositions(body_index);
-    if (history_index * VERTEX_SIZE > data.size()) return;
+    // After a long jump, everything in the ring buffer would be overwritten,
+    // so only the samples that stay visible are collected, like after a seek.
+    const unsigned vertices = capacity / VERTEX_SIZE;
+    const unsigned first_sample = (history_index + stride - 1) / stride;
+    const unsigned end_sample = std::min<unsigned>(
+        until_history_index / stride + 1, data.size() / VERTEX_SIZE);
+    if (end_sample > first_sample && end_sample - first_sample > vertices) {
+        start = 0;
+        length = 0;
+        history_index = (end_sample - vertices) * stride;
+    }
 
-    unsigned end = (start + length) % MAX_BUFFER_LENGTH;
-    Q_ASSERT(end + VERTEX_SIZE <= MAX_BUFFER_LENGTH);
+    // Collect the new vertices first, they will be written into the ring
+    // buffer one after another, starting at its current end.
+    const unsigned first_end = (start + length) % capacity;
+    staging.clear();
+    while (history_index <= until_history_index) {
+        // the first position at this level that wasn't written yet
+        const unsigned sample = (history_index + stride - 1) / stride;
+        if (sample * stride > until_history_index) break;
+        if ((sample + 1) * VERTEX_SIZE > data.size()) break;
+        staging.insert(staging.end(), &data[sample * VERTEX_SIZE],
+                       &data[sample * VERTEX_SIZE] + VERTEX_SIZE);
 
-    vertex_buffer.bind();
-    vertex_buffer.write(end * sizeof(GLfloat),
-                        &data[history_index * VERTEX_SIZE],
-                        VERTEX_SIZE * sizeof(GLfloat));
-    vertex_buffer.release();
+        history_index = sample * stride + 1;
+        if (full()) {
+            start = (start + VERTEX_SIZE) % capacity;
+            // repeat the ending vertex at the beginning, so that the line
+            // strip is continuos (OpenGL doesn't know it's a ring)
+            if (start == 0) history_index--;
+        } else {
+            length += VERTEX_SIZE;
+        }
+    }
+    return upload(first_end);
+}
 
-    if (full()) {
-        start = (start + VERTEX_SIZE) % MAX_BUFFER_LENGTH;
-        // repeat the ending vertex at the beginning, so that the line strip is
-        // continuos (OpenGL doesn't know it's a ring)
-        if (start == 0) history_index--;
-    } else {
-        length += VERTEX_SIZE;
+unsigned
+Orbit::upload(unsigned position)
+{
+    if (staging.empty()) return 0;
+    const GLfloat *data = staging.data();
+    unsigned size = staging.size();
+    // older vertices would be overwritten in the same update anyway
+    if (size > capacity) {
+        const unsigned skipped = size - capacity;
+        data += skipped;
+        size = capacity;
+        position = (position + skipped) % capacity;
     }
-    history_index++;
-    if (history_index <= until_history_index)
-        updateData(until_history_index);
+    Q_ASSERT(position % VERTEX_SIZE == 0);
+
+    // at most two continuous ranges - until the end of the ring buffer and
+    // the rest from its beginning
+    const unsigned first = std::min(size, capacity - position);
+    vertex_buffer->bind();
+    vertex_buffer->write((offset + position) * sizeof(GLfloat), data,
+                         first * sizeof(GLfloat));
+    if (first < size) {
+        vertex_buffer->write(offset * sizeof(GLfloat), data + first,
+                             (size - first) * sizeof(GLfloat));
+    }
+    vertex_buffer->release();
+    return size * sizeof(GLfloat);
 }
 
-void
-Orbit::draw(QOpenGLShaderProgram *program, unsigned vertex_count,
-            const char* shader_variable)
+unsigned
+Orbit::seek(unsigned until_history_index)
 {
-    if (vertex_count == 0) return;
-    vertex_buffer.bind();
-    program->enableAttributeArray(shader_variable);
-    program->setAttributeBuffer(shader_variable, GL_FLOAT, 0, VERTEX_SIZE);
-    vertex_buffer.release();
-    unsigned count = std::min((length - start)/VERTEX_SIZE, vertex_count);
-    Q_ASSERT(count < length / VERTEX_SIZE);
-    glDrawArrays(GL_LINE_STRIP, start / VERTEX_SIZE, count);
+    start = 0;
+    length = 0;
+    // the buffer can't show more than this, so don't write anything older
+    const unsigned vertices = capacity / VERTEX_SIZE - 1;
+    history_index = until_history_index > vertices
+                    ? until_history_index - vertices : 0;
+    return updateData(until_history_index);
+}
 
-    if (full()) {
-        // OpenGL doesn't know that the buffer is supposed to be a ring, so we
-        // have to wrap it around ourselves
-        count = vertex_count - count;
-        unsigned end = (start + length) % MAX_BUFFER_LENGTH;
-        count = std::min((unsigned)end / VERTEX_SIZE, count);
-        glDrawArrays(GL_LINE_STRIP, 0, count);
-        // the connection point between the last buffer vertex and the first
-        // one will be drawn because we have saved the last buffer vertex at
+void
+Orbit::ranges(std::vector<GLint> *firsts, std::vector<GLsizei> *counts)
+{
+    if (length < 2 * VERTEX_SIZE) return;
+    const unsigned first = (offset + start) / VERTEX_SIZE;
+    if (!full()) {
+        firsts->push_back(first);
+        counts->push_back(length / VERTEX_SIZE);
+        return;
+    }
+    // OpenGL doesn't know that the segment is supposed to be a ring, so we
+    // have to wrap it around ourselves - from the oldest vertex until the end
+    // of the segment and then the rest from its beginning
+    firsts->push_back(first);
+    counts->push_back((capacity - start) / VERTEX_SIZE);
+    if (start > 0) {
+        // the connection point between the last vertex of the segment and the
+        // first one will be drawn because we have saved the last vertex at
         // the beginning too (at the cost of some data duplication...)
+        firsts->push_back(offset / VERTEX_SIZE);
+        counts->push_back(start / VERTEX_SIZE);
     }
 }
@@ -24,61 +24,79 @@
 #define __ORBIT_H__
 
 #include <memory>
+#include <vector>
 #include <QOpenGLFunctions>
 #include <QOpenGLBuffer>
 #include "simulationhistory.h"
 
 
-class QOpenGLShaderProgram;
-
 /** Draw the trajectory of a body in the simulation history.
  *
  * Since it has a limited capacity, old values will be overwritten with new
  * ones when necessary (it implements a circular buffer), creating the effect
  * of a tail going behind the planet.
  *
- * It uses an OpenGL buffer and requires that some basic vertex and fragment
- * shader is available (ideally without any lighting).
+ * It doesn't own any OpenGL buffer, it only writes into its own segment of a
+ * buffer shared by all the orbits, see OrbitBuffer.
  */
-class Orbit : protected QOpenGLFunctions
+class Orbit
 {
 public:
-    /// Use the body with body_index in the history to draw its orbit.
-    Orbit(const std::shared_ptr<SimulationHistory> history,
-          const unsigned body_index);
-
-    /** Call this in initializeGL() or the equivalent - it assumes that the
-     * OpenGL context is bound, so it has to be separate from the constructor.
+    /** Use the body with body_index in the history to draw its orbit.
+     *
+     * @param buffer: allocated OpenGL buffer shared with other orbits
+     * @param offset: index of the first float of this orbit's segment
+     * @param capacity: how many floats (3x per vertex) can the segment store,
+     *      has to be a multiple of 3 and hold at least 2 vertices
      */
-    void initialize();
+    Orbit(const std::shared_ptr<SimulationHistory> history,
+          const unsigned body_index, QOpenGLBuffer *buffer,
+          unsigned offset, unsigned capacity);
 
     /** Write positions from the history into the OpenGL buffer until the
      * `until_history_index` is reached.
      * @param history_index: ranges from 0 to SimulationHistory::historySize(),
      *      a higher value will be ignored
+     * @param level: read only every 2^level-th position from the history, see
+     *      SimulationHistory::levelForStride
+     * @return how many bytes were written into the OpenGL buffer
      */
-    void updateData(unsigned until_history_index);
+    unsigned updateData(unsigned until_history_index, unsigned level = 0);
 
-    /** Draw a line strip starting from the oldest values stored to the newest,
-     * limited by vertex_count.
-     *
-     * @param shader_variable: name of the input variable to the vertex shader
-     *      with positions of the vertices
-     * @todo use until_history_index too, this is meaningless in a ring buffer
+    /** Forget the stored positions and fill the buffer again with the
+     * positions just before and including `history_index`, e.g. after jumping
+     * back in time.
+     * @return how many bytes were written into the OpenGL buffer
      */
-    void draw(QOpenGLShaderProgram *program, unsigned vertex_count,
-              const char* shader_variable = "vertex");
+    unsigned seek(unsigned history_index);
 
-private:
-    /// How many floating point numbers can the opengl buffer store. This will
-    /// be allocated even if not in use.
-    const unsigned MAX_BUFFER_LENGTH = 6000;
+    /** Append the ranges of vertices (indexed from the start of the shared
+     * buffer) which form the line strip from the oldest stored values to the
+     * newest. There are at most two of them, since OpenGL doesn't know the
+     * segment is a ring.
+     */
+    void ranges(std::vector<GLint> *firsts, std::vector<GLsizei> *counts);
 
-    QOpenGLBuffer vertex_buffer;
+private:
+    QOpenGLBuffer *vertex_buffer;
     std::shared_ptr<SimulationHistory> simulation_history;
     /// Index of the body in the SimulationHistory which will be shown.
     unsigned body_index;
 
+    /// Where the segment of this orbit begins in the shared buffer (index of
+    /// a float).
+    unsigned offset;
+    /// How many floating point numbers can the segment store.
+    unsigned capacity;
+
+    /// New vertices collected by Orbit::updateData before writing them.
+    std::vector<GLfloat> staging;
+
+    /// Write Orbit::staging into the ring buffer, starting at `position`
+    /// (index of a float), using at most two writes. Returns the number of
+    /// bytes written.
+    unsigned upload(unsigned position);
+
     /// Index into the ring buffer (3x per vertex)
     unsigned start = 0;
     /// How many floats are already stored (3x per vertex)
@@ -90,7 +108,7 @@ private:
     unsigned history_index = 0;
 
     bool full() {
-        return length == MAX_BUFFER_LENGTH;
+        return length == capacity;
     }
 
     bool empty() {
@@ -98,7 +116,7 @@ private:
     }
 
     unsigned available() {
-        return MAX_BUFFER_LENGTH - length;
+        return capacity - length;
     }
 };
 
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+
+/**
+ * @file
+ */
+#include "gui/orbitbuffer.h"
+
+#include <algorithm>
+#include <QOpenGLShaderProgram>
+#include <QDebug>
+
+const unsigned VERTEX_SIZE = 3;
+/// An orbit has to be able to store at least one line.
+const unsigned MIN_ORBIT_LENGTH = 2;
+
+
+void
+OrbitBuffer::initialize()
+{
+    multi_draw.initialize();
+    qDebug() << "glMultiDrawArrays supported:" << multi_draw.supported();
+    vertex_buffer.create();
+    vertex_buffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+}
+
+void
+OrbitBuffer::load(const std::shared_ptr<SimulationHistory> history,
+                  unsigned memory_budget)
+{
+    Q_ASSERT(history != nullptr);
+    orbits.clear();
+    const unsigned n = history->universeSize();
+    if (n == 0) return;
+
+    orbit_length = orbitLength(n, memory_budget);
+    const unsigned segment = orbit_length * VERTEX_SIZE;
+    uploaded_bytes = 0;
+    if (std::size_t(n) * segment * sizeof(GLfloat) > memory_budget) {
+        qDebug() << "Trail memory budget of" << memory_budget << "bytes"
+                 << "exceeded, every one of the" << n << "trails has"
+                 << orbit_length << "vertices";
+    }
+
+    vertex_buffer.bind();
+    vertex_buffer.allocate(n * segment * sizeof(GLfloat));
+    vertex_buffer.release();
+
+    orbits.reserve(n);
+    for (unsigned i = 0; i < n; i++)
+        orbits.push_back(Orbit(history, i, &vertex_buffer, i * segment,
+                               segment));
+}
+
+unsigned
+OrbitBuffer::orbitLength(unsigned body_count, unsigned memory_budget)
+{
+    if (body_count == 0) return 0;
+    const unsigned length =
+        memory_budget / (body_count * VERTEX_SIZE * sizeof(GLfloat));
+    return std::max(length, MIN_ORBIT_LENGTH);
+}
+
+void
+OrbitBuffer::updateData(unsigned until_history_index, unsigned level)
+{
+    for (auto& orbit: orbits)
+        uploaded_bytes += orbit.updateData(until_history_index, level);
+}
+
+void
+OrbitBuffer::seek(unsigned history_index)
+{
+    for (auto& orbit: orbits)
+        uploaded_bytes += orbit.seek(history_index);
+}
+
+unsigned
+OrbitBuffer::draw(QOpenGLShaderProgram *program, const char* shader_variable)
+{
+    firsts.clear();
+    counts.clear();
+    for (auto& orbit: orbits)
+        orbit.ranges(&firsts, &counts);
+    if (firsts.empty()) return 0;
+
+    vertex_buffer.bind();
+    program->enableAttributeArray(shader_variable);
+    program->setAttributeBuffer(shader_variable, GL_FLOAT, 0, VERTEX_SIZE);
+    vertex_buffer.release();
+    return multi_draw.draw(GL_LINE_STRIP, firsts, counts);
+}
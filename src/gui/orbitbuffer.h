@@ -0,0 +1,107 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+
+/**
+ * @file
+ */
+#ifndef __ORBIT_BUFFER_H__
+#define __ORBIT_BUFFER_H__
+
+#include <memory>
+#include <vector>
+#include <QOpenGLBuffer>
+#include "gui/multidraw.h"
+#include "gui/orbit.h"
+#include "simulationhistory.h"
+
+
+class QOpenGLShaderProgram;
+
+/** Trajectories of all the bodies in the simulation history, stored in one
+ * OpenGL buffer.
+ *
+ * Every body gets a segment of the same size, which is determined by the
+ * memory budget of the buffer. All the orbits are then drawn with a single
+ * glMultiDrawArrays call, or one glDrawArrays per orbit if it's not available.
+ */
+class OrbitBuffer
+{
+public:
+    OrbitBuffer() = default;
+
+    /** Call this in initializeGL() or the equivalent - it assumes that the
+     * OpenGL context is bound, so it has to be separate from the constructor.
+     */
+    void initialize();
+
+    /** Allocate the segments for all the bodies in the history and forget all
+     * the previous orbits. Assumes that the OpenGL context is bound.
+     *
+     * @param memory_budget: size of the whole buffer in bytes, exceeded only
+     *      if it can't hold the minimal trails of all the bodies
+     */
+    void load(const std::shared_ptr<SimulationHistory> history,
+              unsigned memory_budget);
+
+    /// @see Orbit::updateData
+    void updateData(unsigned until_history_index, unsigned level = 0);
+
+    /// @see Orbit::seek
+    void seek(unsigned history_index);
+
+    /** Draw line strips of all the orbits.
+     *
+     * @param shader_variable: name of the input variable to the vertex shader
+     *      with positions of the vertices
+     * @return number of the issued draw calls
+     */
+    unsigned draw(QOpenGLShaderProgram *program,
+              const char* shader_variable = "vertex");
+
+    /// How many bytes were written into the buffer since it was loaded.
+    unsigned long uploadedBytes() const {
+        return uploaded_bytes;
+    }
+
+    /// How many vertices can every orbit store.
+    unsigned orbitLength() const {
+        return orbit_length;
+    }
+
+    /// How many vertices can every orbit store if the buffer of the given
+    /// size (in bytes) is shared by `body_count` orbits.
+    static unsigned orbitLength(unsigned body_count, unsigned memory_budget);
+
+private:
+    Q_DISABLE_COPY(OrbitBuffer)
+
+    QOpenGLBuffer vertex_buffer;
+    /// Every orbit keeps a pointer to OrbitBuffer::vertex_buffer.
+    std::vector<Orbit> orbits;
+    unsigned orbit_length = 0;
+    unsigned long uploaded_bytes = 0;
+
+    MultiDraw multi_draw;
+    /// Ranges of all the orbits, collected for every draw.
+    std::vector<GLint> firsts;
+    std::vector<GLsizei> counts;
+};
+
+#endif  // __ORBIT_BUFFER_H__
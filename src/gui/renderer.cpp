@@ -0,0 +1,434 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+
+/**
+ * @file
+ */
+#include "gui/renderer.h"
+
+#include <QOpenGLContext>
+#include <QVector4D>
+#include <QDebug>
+#include "exceptions.h"
+
+/// Bodies with a smaller radius on the screen (in pixels) are drawn as point
+/// sprites instead of tessellated spheres.
+const float POINT_SPRITE_MAX_RADIUS = 4;
+/// GPU time is measured with this many sets of queries used in turns, i.e.
+/// the results are read this many frames later.
+const unsigned TIMER_QUERY_FRAMES = 3;
+
+#ifndef GL_PROGRAM_POINT_SIZE
+#define GL_PROGRAM_POINT_SIZE 0x8642
+#endif
+#ifndef GL_POINT_SPRITE
+#define GL_POINT_SPRITE 0x8861
+#endif
+
+
+Renderer::Renderer(std::shared_ptr<SimulationHistory> const history)
+    : simulation_history(history)
+{
+    Q_ASSERT(history != nullptr);
+}
+
+void
+Renderer::initialize()
+{
+    initializeOpenGLFunctions();
+    initializeShaders();
+    sphere.initialize(1.0);
+    orbits.initialize();
+    trajectories.initialize();
+
+    const QOpenGLContext *context = QOpenGLContext::currentContext();
+    instancing_supported = context->format().version() >= qMakePair(3, 3)
+                           || context->hasExtension("GL_ARB_instanced_arrays");
+    instance_buffer.create();
+    instance_buffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    point_buffer.create();
+    point_buffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    qDebug() << "Instanced rendering supported:" << instancing_supported;
+
+#ifndef QT_OPENGL_ES_2
+    if (context->format().version() >= qMakePair(3, 3)
+            || context->hasExtension("GL_ARB_timer_query")) {
+        for (unsigned i = 0; i < TIMER_QUERY_FRAMES * RENDER_PASS_COUNT; i++) {
+            std::unique_ptr<QOpenGLTimerQuery> query(new QOpenGLTimerQuery);
+            if (!query->create()) {
+                timer_queries.clear();
+                break;
+            }
+            timer_queries.push_back(std::move(query));
+        }
+        timer_query_started.assign(timer_queries.size(), false);
+    }
+    qDebug() << "Timer queries supported:" << !timer_queries.empty();
+#endif
+
+    glClearColor(0, 0, 0, 1);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glEnable(GL_MULTISAMPLE);
+    glEnable(GL_BLEND);
+
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glLineWidth(2);
+    // let the point shader set the size of the sprites, compatibility
+    // contexts also need point sprites enabled to get gl_PointCoord
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    if (context->format().profile() != QSurfaceFormat::CoreProfile)
+        glEnable(GL_POINT_SPRITE);
+
+    printGlErrors();
+}
+
+void
+Renderer::initializeShaders()
+{
+    initializeShader(&point_program, ":/shaders/vshader_point.glsl",
+                     ":/shaders/fshader_point.glsl");
+    initializeShader(&program, ":/shaders/vshader.glsl",
+                     ":/shaders/fshader.glsl");
+}
+
+void
+Renderer::initializeShader(QOpenGLShaderProgram *shader_program,
+                           const QString& vertex_shader,
+                           const QString& fragment_shader)
+{
+    try {
+        if (!shader_program->addShaderFromSourceFile(QOpenGLShader::Vertex,
+                vertex_shader))
+            throw Exception("Could not compile vertex shader");
+        if (!shader_program->addShaderFromSourceFile(QOpenGLShader::Fragment,
+                fragment_shader))
+            throw Exception("Could not compile fragment shader");
+        if (!shader_program->link())
+            throw Exception("Could not link shader pipeline");
+        if (!shader_program->bind())
+            throw Exception("Could not bind shader pipeline");
+    } catch(Exception&) {
+        qDebug() << shader_program->log();
+        throw;
+    }
+}
+
+void
+Renderer::loadUniverse(physics::UniverseModel u, parser::ProjectSettings p)
+{
+    universe = u;
+    settings = p;
+    resident_trajectories = settings.resident_trajectories
+        && trajectories.load(simulation_history);
+    if (!resident_trajectories)
+        orbits.load(simulation_history, settings.trail_memory_budget);
+    last_uploaded_bytes = uploadedBytes();
+}
+
+void
+Renderer::resize(int width, int height)
+{
+    qreal aspect = qreal(width) / qreal(height ? height : 1);
+    const qreal zNear = 1.0, zFar = 1024.0, fov = 45.0;
+    projection.setToIdentity();
+    projection.perspective(fov, aspect, zNear, zFar);
+    viewport_height = height ? height : 1;
+}
+
+void
+Renderer::seek(unsigned history_index)
+{
+    // the resident trajectories only need to be drawn from another offset
+    if (!resident_trajectories)
+        orbits.seek(history_index);
+}
+
+void
+Renderer::updateTrajectories(unsigned history_index, unsigned level)
+{
+    if (!resident_trajectories)
+        orbits.updateData(history_index, level);
+}
+
+void
+Renderer::paint(double history_position,
+                const QVector3D& translation,
+                const QQuaternion& rotation,
+                float scale)
+{
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    frame_statistics.draw_calls = 0;
+    frame_statistics.uploaded_bytes = 0;
+    if (simulation_history->empty()) return;
+    const unsigned history_index = history_position;
+
+    QMatrix4x4 view;
+    view.translate(0.0, 0.0, -3.0);
+    view.translate(translation);
+    view.rotate(rotation);
+    view.scale(scale);
+
+    Q_ASSERT(universe.size() == simulation_history->universeSize());
+    computeInstances(view, history_position, scale);
+    beginPass(POINTS_PASS);
+    if (!point_instances.empty()) {
+        point_program.bind();
+        point_buffer.bind();
+        point_buffer.allocate(point_instances.data(),
+                              point_instances.size() * sizeof(GLfloat));
+        point_program.enableAttributeArray("instance");
+        point_program.setAttributeBuffer("instance", GL_FLOAT, 0, 4);
+        point_buffer.release();
+        point_program.setUniformValue("color", settings.body_color);
+        point_program.setUniformValue("mvp_matrix", projection * view);
+        point_program.setUniformValue("point_scale", pointScale(scale));
+        glDrawArrays(GL_POINTS, 0, point_instances.size() / 4);
+        frame_statistics.draw_calls++;
+        point_program.disableAttributeArray("instance");
+    }
+    endPass(POINTS_PASS);
+
+    beginPass(SPHERES_PASS);
+    program.bind();
+    program.setUniformValue("color", settings.body_color);
+    program.setUniformValue("use_lights", true);
+    if (instancing_supported) {
+        // all the bodies with the same level of detail at once, the model
+        // matrix is applied in the shader
+        instance_buffer.bind();
+        instance_buffer.allocate(instances.data(),
+                                 instances.size() * sizeof(GLfloat));
+        instance_buffer.release();
+        program.setUniformValue("instanced", true);
+        program.setUniformValue("mvp_matrix", projection * view);
+        unsigned first = 0;
+        for(unsigned level = 0; level < lod_instances.size(); level++) {
+            const unsigned count = lod_instances[level].size() / 4;
+            if (count == 0) continue;
+            sphere.drawInstanced(&program, &instance_buffer, first, count,
+                                 level);
+            frame_statistics.draw_calls++;
+            first += count;
+        }
+        program.setUniformValue("instanced", false);
+    } else {
+        for(unsigned level = 0; level < lod_instances.size(); level++) {
+            const auto& lod = lod_instances[level];
+            for(unsigned i = 0; i < lod.size() / 4; i++) {
+                QMatrix4x4 model;
+                model.translate(lod[i * 4], lod[i * 4 + 1], lod[i * 4 + 2]);
+                model.scale(lod[i * 4 + 3]);
+                program.setUniformValue("mvp_matrix",
+                                        projection * view * model);
+                sphere.draw(&program, level);
+                frame_statistics.draw_calls++;
+            }
+        }
+    }
+    endPass(SPHERES_PASS);
+
+    beginPass(TRAJECTORIES_PASS);
+    program.setUniformValue("color", settings.orbit_color);
+    program.setUniformValue("use_lights", false);
+    program.setUniformValue("mvp_matrix", projection * view);
+    if (resident_trajectories && !trajectories.update()) {
+        qDebug() << "Simulation history doesn't fit into GPU memory, drawing"
+                 << "the trajectories from ring buffers";
+        resident_trajectories = false;
+        // loading forgets what was written into the ring buffers before
+        last_uploaded_bytes -= orbits.uploadedBytes();
+        orbits.load(simulation_history, settings.trail_memory_budget);
+        orbits.seek(history_index);
+    }
+    if (resident_trajectories) {
+        // as long as the trails in the ring buffers would be at full speed
+        const unsigned length = OrbitBuffer::orbitLength(
+            universe.size(), settings.trail_memory_budget);
+        frame_statistics.draw_calls += trajectories.draw(
+            &program, history_index > length ? history_index - length : 0,
+            history_index);
+    } else {
+        frame_statistics.draw_calls += orbits.draw(&program);
+    }
+    endPass(TRAJECTORIES_PASS);
+    // only now, the resident trajectories are uploaded during the frame
+    frame_statistics.uploaded_bytes = uploadedBytes() - last_uploaded_bytes;
+    last_uploaded_bytes = uploadedBytes();
+    frame_counter++;
+    printGlErrors();
+}
+
+void
+Renderer::beginPass(RenderPass pass)
+{
+#ifndef QT_OPENGL_ES_2
+    if (timer_queries.empty()) return;
+    const unsigned i =
+        (frame_counter % TIMER_QUERY_FRAMES) * RENDER_PASS_COUNT + pass;
+    // it was started TIMER_QUERY_FRAMES frames ago, so it should be finished
+    // and reading it won't stall, otherwise the result is skipped
+    if (timer_query_started[i] && timer_queries[i]->isResultAvailable()) {
+        frame_statistics.gpu_time[pass] =
+            timer_queries[i]->waitForResult() / 1e6;  // ns to ms
+    }
+    timer_queries[i]->begin();
+    timer_query_started[i] = true;
+#else
+    Q_UNUSED(pass);
+#endif
+}
+
+void
+Renderer::endPass(RenderPass pass)
+{
+#ifndef QT_OPENGL_ES_2
+    if (timer_queries.empty()) return;
+    const unsigned i =
+        (frame_counter % TIMER_QUERY_FRAMES) * RENDER_PASS_COUNT + pass;
+    timer_queries[i]->end();
+#else
+    Q_UNUSED(pass);
+#endif
+}
+
+unsigned long
+Renderer::uploadedBytes() const
+{
+    return orbits.uploadedBytes() + trajectories.uploadedBytes();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+float
+Renderer::universeRadius() const
+{
+    // the history positions are relative to the visual center
+    const physics::Vector center = universe[settings.visual_center].position;
+    float max = 0;
+    for (const auto& body: universe) {
+        float distance = abs(body.position - center);
+        if(distance > max) max = distance;
+    }
+    // there is nothing but the center
+    if (max <= 0) return 1;
+    return max;
+}
+
+float
+Renderer::pointScale(float scale)
+{
+    return scale * projection(1, 1) * viewport_height / 2;
+}
+
+void
+Renderer::computeInstances(const QMatrix4x4& view, double history_position,
+                           float scale)
+{
+    const unsigned history_index = history_position;
+    const bool interpolate = history_position > history_index;
+    const HistoryPosition position =
+        interpolate ? simulation_history->seek(timeAt(history_position))
+                    : HistoryPosition();
+    const QMatrix4x4 mvp = projection * view;
+    const float point_scale = pointScale(scale);
+    lod_instances.resize(sphere.levels());
+    for (auto& lod: lod_instances)
+        lod.clear();
+    point_instances.clear();
+    for(unsigned i = 0; i < universe.size(); i++) {
+        const auto& body = universe[i];
+        QVector3D p;
+        if (interpolate) {
+            p = simulation_history->interpolatedBodyPosition(i, position);
+        } else {
+            p = simulation_history->bodyPositions(i).vertex(history_index);
+        }
+        const float radius = body.radius
+                             * body.visible_size_multiplier
+                             * settings.visible_size_multiplier;
+
+        // radius of the body on the screen, in pixels (the body is behind
+        // the camera if w isn't positive, so it doesn't need any details)
+        const float w = (mvp * QVector4D(p, 1.0)).w();
+        const float screen_radius = w > 0 ? radius * point_scale / w : 0;
+        const bool as_point = w > 0
+                              && screen_radius < POINT_SPRITE_MAX_RADIUS;
+        auto& target = as_point
+                       ? point_instances
+                       : lod_instances[sphere.levelForRadius(screen_radius)];
+        target.push_back(p.x());
+        target.push_back(p.y());
+        target.push_back(p.z());
+        target.push_back(radius);
+    }
+    instances.clear();
+    for (const auto& lod: lod_instances)
+        instances.insert(instances.end(), lod.begin(), lod.end());
+}
+
+physics::DOUBLE
+Renderer::timeAt(double history_position) const
+{
+    const unsigned history_index = history_position;
+    const physics::DOUBLE time = simulation_history->savedTime(history_index);
+    const double fraction = history_position - history_index;
+    if (fraction <= 0
+            || history_index + 1 >= simulation_history->historySize())
+        return time;
+    const physics::DOUBLE next =
+        simulation_history->savedTime(history_index + 1);
+    return time + fraction * (next - time);
+}
+
+void
+Renderer::printGlErrors()
+{
+    GLenum error = GL_NO_ERROR;
+    do {
+        error = glGetError();
+        if (error != GL_NO_ERROR) {
+            QString s = glErrorToString(error);
+            qDebug() << "OpenGL Error:" << s;
+        }
+    } while (error != GL_NO_ERROR);
+}
+
+QString
+Renderer::glErrorToString(GLenum error_code)
+{
+    switch(error_code) {
+    case GL_NO_ERROR:
+        return "No error";
+    case GL_INVALID_ENUM:
+        return "Invalid enumerant";
+    case GL_INVALID_VALUE:
+        return "Invalid value";
+    case GL_INVALID_OPERATION:
+        return "Invalid operation";
+    case GL_STACK_OVERFLOW:
+        return "Stack overflow";
+    case GL_STACK_UNDERFLOW:
+        return "Stack underflow";
+    case GL_OUT_OF_MEMORY:
+        return "Out of memory";
+    default:
+        return "Unknown error";
+    }
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+
+/**
+ * @file
+ */
+#ifndef __RENDERER_H__
+#define __RENDERER_H__
+
+#include <memory>
+#include <vector>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLBuffer>
+#ifndef QT_OPENGL_ES_2
+#include <QOpenGLTimerQuery>
+#endif
+#include <QMatrix4x4>
+#include <QQuaternion>
+#include <QVector3D>
+
+#include "physics/universemodel.h"
+#include "simulationhistory.h"
+#include "projectparser.h"
+#include "gui/sphere.h"
+#include "gui/orbitbuffer.h"
+#include "gui/trajectorybuffer.h"
+#include "gui/framestatistics.h"
+
+/** Draws the bodies and their trajectories from the simulation history into
+ * the current OpenGL context.
+ *
+ * It doesn't care where the frame ends up, so it is shared by the Animation
+ * widget and by the OffscreenRenderer. All methods except the constructor
+ * assume that the OpenGL context is bound.
+ */
+class Renderer : protected QOpenGLExtraFunctions
+{
+public:
+    /// @param history Simulation results that will be drawn.
+    explicit Renderer(std::shared_ptr<SimulationHistory> const history);
+
+    /// Call this in initializeGL() or the equivalent.
+    void initialize();
+
+    /// Load new universe informations and forget the drawn trajectories.
+    void loadUniverse(physics::UniverseModel u, parser::ProjectSettings p);
+
+    /// Set the size of the viewport, in pixels.
+    void resize(int width, int height);
+
+    /// Forget the trajectories and draw them again until `history_index`.
+    void seek(unsigned history_index);
+
+    /** Extend the trajectories until `history_index`.
+     * @param level: see SimulationHistory::levelForStride
+     */
+    void updateTrajectories(unsigned history_index, unsigned level);
+
+    /** Draw the frame.
+     * @param history_position: index in the simulation history including the
+     *      fraction between two saved states, which are interpolated
+     * @param translation, rotation, scale: camera position
+     */
+    void paint(double history_position,
+               const QVector3D& translation,
+               const QQuaternion& rotation,
+               float scale);
+
+    /// Get the simulation time (in seconds) at the position in the history.
+    physics::DOUBLE timeAt(double history_position) const;
+
+    /// Distance of the furthest body from the visual center at the start.
+    float universeRadius() const;
+
+    /// Measurements of the last painted frame. The frame and CPU times are
+    /// left to the caller.
+    const FrameStatistics& statistics() const {
+        return frame_statistics;
+    }
+
+    void printGlErrors();
+
+private:
+    QString glErrorToString(GLenum error_code);
+    void initializeShaders();
+    void initializeShader(QOpenGLShaderProgram *shader_program,
+                          const QString& vertex_shader,
+                          const QString& fragment_shader);
+
+    /// Fill Renderer::instances and Renderer::point_instances with the
+    /// bodies drawn in this frame, depending on their size on the screen.
+    /// The spheres are sorted by their level of detail.
+    void computeInstances(const QMatrix4x4& view, double history_position,
+                          float scale);
+    /// Factor to get the radius in pixels from the radius of a body divided
+    /// by its distance from the camera.
+    float pointScale(float scale);
+
+    /// Start measuring the GPU time of the pass, collecting an older result.
+    void beginPass(RenderPass pass);
+    void endPass(RenderPass pass);
+    /// Bytes written into the trajectory buffers since they were loaded.
+    unsigned long uploadedBytes() const;
+
+    QOpenGLShaderProgram program;
+    /// Draws bodies as point sprites (sphere impostors).
+    QOpenGLShaderProgram point_program;
+    QMatrix4x4 projection;
+    int viewport_height = 1;
+
+    /// Data to be drawn.
+    const std::shared_ptr<SimulationHistory> simulation_history;
+    /// Local copy of the universe info (used to get the names, colors, etc.)
+    physics::UniverseModel universe;
+    parser::ProjectSettings settings;
+
+    /// Can all the bodies be drawn with one instanced draw call per level of
+    /// detail?
+    bool instancing_supported = false;
+    /// Position (3 numbers) and scale (1 number) of each body in the frame
+    /// that is drawn as a sphere, for each level of detail of the Sphere.
+    std::vector<std::vector<GLfloat> > lod_instances;
+    /// All the Renderer::lod_instances one after another.
+    std::vector<GLfloat> instances;
+    QOpenGLBuffer instance_buffer;
+    /// Position and radius of each body in the frame that is so small on the
+    /// screen that it is drawn as a point sprite instead of a sphere.
+    std::vector<GLfloat> point_instances;
+    QOpenGLBuffer point_buffer;
+
+    // models
+    Sphere sphere;
+    /// Used unless Renderer::resident_trajectories is set.
+    OrbitBuffer orbits;
+    /// Used if Renderer::resident_trajectories is set.
+    TrajectoryBuffer trajectories;
+    /// ProjectSettings::resident_trajectories, turned off once the history
+    /// doesn't fit into the memory budget of TrajectoryBuffer.
+    bool resident_trajectories = false;
+
+    FrameStatistics frame_statistics;
+    /// Value of Renderer::uploadedBytes when the last frame was painted.
+    unsigned long last_uploaded_bytes = 0;
+    /// Number of painted frames.
+    unsigned frame_counter = 0;
+#ifndef QT_OPENGL_ES_2
+    /** One query for each RenderPass in each of the last few frames. They are
+     * used in turns, so that the results can be read without waiting for the
+     * GPU. Empty if timer queries aren't supported.
+     */
+    std::vector<std::unique_ptr<QOpenGLTimerQuery> > timer_queries;
+    /// Whether the query at the same index was used and has a result.
+    std::vector<bool> timer_query_started;
+#endif
+};
+
+#endif  // __RENDERER_H__
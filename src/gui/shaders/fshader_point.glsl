@@ -0,0 +1,25 @@
+#version 130
+
+uniform vec4 color;
+
+// Draws the point sprite as a sphere impostor - the fragments outside of the
+// circle are discarded and the rest is lit as if it was the front half of a
+// sphere.
+float light(vec3 norm)
+{
+    vec3 lightDir = vec3(1,1,-1);
+    float ambient = 0.2;
+
+    float dotp = dot(normalize(norm), normalize(lightDir));
+    return max(mix(ambient,1,dotp), ambient);
+}
+
+void main()
+{
+    vec2 p = gl_PointCoord * 2.0 - 1.0;
+    float r2 = dot(p, p);
+    if (r2 > 1.0)
+        discard;
+    vec3 normal = vec3(p.x, -p.y, -sqrt(1.0 - r2));
+    gl_FragColor = color * light(normal);
+}
@@ -2,12 +2,20 @@
 
 in vec4 vertex;
 in vec4 normal;
+// position (xyz) and scale (w) of one body when drawing instanced spheres
+in vec4 instance;
 uniform mat4 mvp_matrix;
+uniform bool instanced;
 
 varying vec4 normal_frag;
 
 void main()
 {
-    gl_Position = mvp_matrix * vertex;
+    if (instanced) {
+        gl_Position = mvp_matrix * vec4(vertex.xyz * instance.w + instance.xyz,
+                                        1.0);
+    } else {
+        gl_Position = mvp_matrix * vertex;
+    }
     normal_frag = normal;
 }
@@ -0,0 +1,13 @@
+#version 130
+
+// position (xyz) and radius (w) of one body
+in vec4 instance;
+uniform mat4 mvp_matrix;
+// converts a radius at the distance 1 from the camera into pixels
+uniform float point_scale;
+
+void main()
+{
+    gl_Position = mvp_matrix * vec4(instance.xyz, 1.0);
+    gl_PointSize = max(2.0 * instance.w * point_scale / gl_Position.w, 1.0);
+}
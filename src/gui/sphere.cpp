@@ -22,13 +22,16 @@
  */
 #include "sphere.h"
 
+#include <algorithm>
 #include <cmath>
-#include <vector>
+#include <map>
+#include <utility>
 #include <QOpenGLShaderProgram>
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
+/// The level of detail L is used for spheres with a smaller radius on the
+/// screen (in pixels) than LOD_MAX_RADIUS[L], the finest one for the rest.
+const float LOD_MAX_RADIUS[] = {8, 24, 72};
+
 
 Sphere::Sphere()
     : index_buffer(QOpenGLBuffer::IndexBuffer)
@@ -36,15 +39,73 @@ Sphere::Sphere()
 }
 
 void
-Sphere::initialize(float radius, unsigned int rings, unsigned int sectors)
+Sphere::initialize(float radius, unsigned levels)
 {
+    Q_ASSERT(levels > 0);
     initializeOpenGLFunctions();
-    generate(radius, rings, sectors);
+    generate(radius, levels);
+}
+
+unsigned
+Sphere::levelForRadius(float radius) const
+{
+    unsigned level = 0;
+    const unsigned thresholds = sizeof(LOD_MAX_RADIUS) / sizeof(float);
+    while (level < thresholds && radius >= LOD_MAX_RADIUS[level])
+        level++;
+    return validLevel(level);
 }
 
 void
-Sphere::draw(QOpenGLShaderProgram *program, const char* shader_variable_vertex,
+Sphere::draw(QOpenGLShaderProgram *program, unsigned level,
+             const char* shader_variable_vertex,
              const char* shader_variable_normal)
+{
+    level = validLevel(level);
+    bindAttributes(program, shader_variable_vertex, shader_variable_normal);
+
+    index_buffer.bind();
+    glDrawElements(GL_TRIANGLES, index_counts[level], GL_UNSIGNED_SHORT,
+                   reinterpret_cast<const void*>(index_offsets[level]));
+    index_buffer.release();
+}
+
+void
+Sphere::drawInstanced(QOpenGLShaderProgram *program,
+                      QOpenGLBuffer *instance_buffer, int first, int count,
+                      unsigned level,
+                      const char* shader_variable_vertex,
+                      const char* shader_variable_normal,
+                      const char* shader_variable_instance)
+{
+    if (count <= 0) return;
+    level = validLevel(level);
+    bindAttributes(program, shader_variable_vertex, shader_variable_normal);
+
+    const int location = program->attributeLocation(shader_variable_instance);
+    instance_buffer->bind();
+    program->enableAttributeArray(location);
+    program->setAttributeBuffer(location, GL_FLOAT,
+                                first * 4 * sizeof(GLfloat), 4);
+    glVertexAttribDivisor(location, 1);
+    instance_buffer->release();
+
+    index_buffer.bind();
+    glDrawElementsInstanced(GL_TRIANGLES, index_counts[level],
+                            GL_UNSIGNED_SHORT,
+                            reinterpret_cast<const void*>(index_offsets[level]),
+                            count);
+    index_buffer.release();
+
+    // don't affect the other draw calls using the same shader program
+    glVertexAttribDivisor(location, 0);
+    program->disableAttributeArray(location);
+}
+
+void
+Sphere::bindAttributes(QOpenGLShaderProgram *program,
+                       const char* shader_variable_vertex,
+                       const char* shader_variable_normal)
 {
     vertex_buffer.bind();
     program->enableAttributeArray(shader_variable_vertex);
@@ -55,75 +116,94 @@ Sphere::draw(QOpenGLShaderProgram *program, const char* shader_variable_vertex,
     program->enableAttributeArray(shader_variable_normal);
     program->setAttributeBuffer(shader_variable_normal, GL_FLOAT, 0, 3);
     normal_buffer.release();
-
-    index_buffer.bind();
-    glDrawElements(GL_QUADS, index_size, GL_UNSIGNED_SHORT, 0);
-    index_buffer.release();
 }
 
 void
-Sphere::generate(float radius, unsigned int rings, unsigned int sectors)
+Sphere::generate(float radius, unsigned levels)
 {
-    std::vector<GLfloat> vertices;
-    std::vector<GLfloat> normals;
-    std::vector<GLfloat> texcoords;
+    // icosahedron, the triangles are counter-clockwise when looking from
+    // the outside
+    const float t = (1.0 + std::sqrt(5.0)) / 2.0;
+    std::vector<GLfloat> normals = {
+        -1,  t,  0,   1,  t,  0,  -1, -t,  0,   1, -t,  0,
+         0, -1,  t,   0,  1,  t,   0, -1, -t,   0,  1, -t,
+         t,  0, -1,   t,  0,  1,  -t,  0, -1,  -t,  0,  1
+    };
+    std::vector<GLushort> triangles = {
+        0, 11, 5,   0, 5, 1,    0, 1, 7,    0, 7, 10,   0, 10, 11,
+        1, 5, 9,    5, 11, 4,   11, 10, 2,  10, 7, 6,   7, 1, 8,
+        3, 9, 4,    3, 4, 2,    3, 2, 6,    3, 6, 8,    3, 8, 9,
+        4, 9, 5,    2, 4, 11,   6, 2, 10,   8, 6, 7,    9, 8, 1
+    };
+    const float length = std::sqrt(1 + t * t);
+    for (auto& n: normals)
+        n /= length;
+
+    // Every level splits each triangle into 4 by adding vertices in the
+    // middle of its edges. The older vertices stay, so all the levels can
+    // share the same vertices.
     std::vector<GLushort> indices;
-
-    float const R = 1.0/(float)(rings - 1);
-    float const S = 1.0/(float)(sectors - 1);
-
-    vertices.resize(rings * sectors * 3);
-    normals.resize(rings * sectors * 3);
-    texcoords.resize(rings * sectors * 2);
-    std::vector<GLfloat>::iterator v = vertices.begin();
-    std::vector<GLfloat>::iterator n = normals.begin();
-    std::vector<GLfloat>::iterator t = texcoords.begin();
-    for(unsigned int r = 0; r < rings; r++) {
-        for(unsigned int s = 0; s < sectors; s++) {
-            float y = std::sin( -M_PI_2 + M_PI * r * R );
-            float x = std::cos(2*M_PI * s * S) * std::sin(M_PI * r * R);
-            float z = std::sin(2*M_PI * s * S) * std::sin(M_PI * r * R);
-
-            *t++ = s*S;
-            *t++ = r*R;
-
-            *v++ = x * radius;
-            *v++ = y * radius;
-            *v++ = z * radius;
-
-            *n++ = x;
-            *n++ = y;
-            *n++ = z;
+    index_offsets.clear();
+    index_counts.clear();
+    for (unsigned level = 0; level < levels; level++) {
+        if (level > 0) {
+            std::map<std::pair<GLushort, GLushort>, GLushort> midpoints;
+            auto midpoint = [&](GLushort a, GLushort b) -> GLushort {
+                const auto key = std::make_pair(std::min(a, b),
+                                                std::max(a, b));
+                const auto found = midpoints.find(key);
+                if (found != midpoints.end())
+                    return found->second;
+                GLfloat m[3];
+                for (unsigned i = 0; i < 3; i++)
+                    m[i] = normals[a * 3 + i] + normals[b * 3 + i];
+                const float l = std::sqrt(m[0]*m[0] + m[1]*m[1] + m[2]*m[2]);
+                const GLushort index = normals.size() / 3;
+                Q_ASSERT(normals.size() / 3 < 0xffff);
+                for (unsigned i = 0; i < 3; i++)
+                    normals.push_back(m[i] / l);
+                midpoints[key] = index;
+                return index;
+            };
+            std::vector<GLushort> subdivided;
+            subdivided.reserve(triangles.size() * 4);
+            for (unsigned i = 0; i < triangles.size(); i += 3) {
+                const GLushort a = triangles[i];
+                const GLushort b = triangles[i + 1];
+                const GLushort c = triangles[i + 2];
+                const GLushort ab = midpoint(a, b);
+                const GLushort bc = midpoint(b, c);
+                const GLushort ca = midpoint(c, a);
+                subdivided.insert(subdivided.end(), {
+                    a, ab, ca,   b, bc, ab,   c, ca, bc,   ab, bc, ca
+                });
+            }
+            triangles.swap(subdivided);
         }
+        index_offsets.push_back(indices.size() * sizeof(GLushort));
+        index_counts.push_back(triangles.size());
+        indices.insert(indices.end(), triangles.begin(), triangles.end());
     }
 
-    indices.resize(rings * sectors * 4);
-    std::vector<GLushort>::iterator i = indices.begin();
-    for(unsigned int r = 0; r < rings-1; r++) {
-        for(unsigned int s = 0; s < sectors-1; s++) {
-            *i++ = r * sectors + s;
-            *i++ = r * sectors + (s+1);
-            *i++ = (r+1) * sectors + (s+1);
-            *i++ = (r+1) * sectors + s;
-        }
-    }
+    std::vector<GLfloat> vertices(normals);
+    for (auto& v: vertices)
+        v *= radius;
 
     vertex_buffer.create();
     vertex_buffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
     vertex_buffer.bind();
-    vertex_buffer.allocate(&(vertices[0]), vertices.size() * sizeof(GLfloat));
+    vertex_buffer.allocate(vertices.data(), vertices.size() * sizeof(GLfloat));
     vertex_buffer.release();
 
     index_buffer.create();
     index_buffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
     index_buffer.bind();
-    index_buffer.allocate(&(indices[0]), indices.size() * sizeof(GLfloat));
+    index_buffer.allocate(indices.data(), indices.size() * sizeof(GLushort));
     index_buffer.release();
-    index_size = indices.size();
 
     normal_buffer.create();
     normal_buffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
     normal_buffer.bind();
-    normal_buffer.allocate(&(normals[0]), normals.size() * sizeof(GLfloat));
+    normal_buffer.allocate(normals.data(), normals.size() * sizeof(GLfloat));
     normal_buffer.release();
 }
@@ -17,23 +17,32 @@
  * NSim. If not, see http://www.gnu.org/licenses/.
  */
 
+
 /**
  * @file
  */
 #ifndef __SPHERE_H__
 #define __SPHERE_H__
 
-#include <QOpenGLFunctions>
+#include <vector>
+#include <QOpenGLExtraFunctions>
 #include <QOpenGLBuffer>
 
 
 class QOpenGLShaderProgram;
 
+/// How many levels of detail does the Sphere have by default. The level 0 is
+/// an icosahedron (20 triangles), every next one has 4x more triangles.
+const unsigned SPHERE_LOD_LEVELS = 4;
+
 /** Draw a sphere in OpenGL.
  *
- * Parts of the code originate from http://stackoverflow.com/a/5989676/770335
+ * The sphere is an icosphere - a subdivided icosahedron. Several levels of
+ * detail are kept in the same buffers, since every subdivision only adds
+ * vertices. The coarser levels should be used for spheres that are small on
+ * the screen, see Sphere::levelForRadius.
  */
-class Sphere : protected QOpenGLFunctions
+class Sphere : protected QOpenGLExtraFunctions
 {
 public:
     Sphere();
@@ -41,28 +50,65 @@ public:
     /** Call this in initializeGL() or the equivalent - it assumes that the
      * OpenGL context is bound, so it has to be separate from the constructor.
      */
-    void initialize(float radius,
-                    unsigned int rings = 20, unsigned int sectors = 20);
+    void initialize(float radius, unsigned levels = SPHERE_LOD_LEVELS);
+
+    /// How many levels of detail are available.
+    unsigned levels() const {
+        return index_counts.size();
+    }
+
+    /** Choose the level of detail for a sphere with the radius (in pixels) on
+     * the screen, so that the edges between triangles aren't visible.
+     */
+    unsigned levelForRadius(float radius) const;
 
     /** Draw the sphere at [0, 0, 0]. To move it around, pass some model-view
      * matrix to the vertex shader.
+     * @param level: level of detail, the finest available one if out of
+     *      range
      * @param shader_variable_vertex: name of the input variable to the vertex
      *      shader with positions of the vertices
      * @param shader_variable_normal: name of the input variable to the vertex
      *      shader with normals of the vertices
      */
-    void draw(QOpenGLShaderProgram *program,
+    void draw(QOpenGLShaderProgram *program, unsigned level = SPHERE_LOD_LEVELS - 1,
               const char* shader_variable_vertex = "vertex",
               const char* shader_variable_normal = "normal");
 
+    /** Draw `count` spheres with one draw call. The instance buffer has to
+     * contain 4 floating point numbers for each sphere - its position and
+     * scale, which are given to the vertex shader. Requires OpenGL 3.3 or the
+     * instanced arrays extension.
+     * @param first: index of the first sphere in the instance buffer
+     * @param level: level of detail, the finest available one if out of
+     *      range
+     * @param shader_variable_instance: name of the input variable to the
+     *      vertex shader with the position and scale of the instance
+     */
+    void drawInstanced(QOpenGLShaderProgram *program,
+                       QOpenGLBuffer *instance_buffer, int first, int count,
+                       unsigned level = SPHERE_LOD_LEVELS - 1,
+                       const char* shader_variable_vertex = "vertex",
+                       const char* shader_variable_normal = "normal",
+                       const char* shader_variable_instance = "instance");
+
 private:
     QOpenGLBuffer vertex_buffer;
     QOpenGLBuffer index_buffer;
     QOpenGLBuffer normal_buffer;
-    /// number of indices in Sphere::index_buffer
-    int index_size = 0;
+    /// Where the indices of each level start in Sphere::index_buffer (in
+    /// bytes) and how many of them there are.
+    std::vector<unsigned> index_offsets;
+    std::vector<int> index_counts;
 
-    void generate(float radius, unsigned int rings, unsigned int sectors);
+    void generate(float radius, unsigned levels);
+    /// Clamp the level of detail to the available ones.
+    unsigned validLevel(unsigned level) const {
+        return level < levels() ? level : levels() - 1;
+    }
+    void bindAttributes(QOpenGLShaderProgram *program,
+                        const char* shader_variable_vertex,
+                        const char* shader_variable_normal);
 };
 
 #endif  // __SPHERE_H__
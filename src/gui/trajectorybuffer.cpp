@@ -0,0 +1,152 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+
+/**
+ * @file
+ */
+#include "gui/trajectorybuffer.h"
+
+#include <algorithm>
+#include <climits>
+#include <QOpenGLShaderProgram>
+
+const unsigned VERTEX_SIZE = 3;
+/// Capacity of the segment of each body after the first upload.
+const unsigned MIN_CAPACITY = 1024;
+
+
+void
+TrajectoryBuffer::initialize()
+{
+    multi_draw.initialize();
+    vertex_buffer.create();
+    vertex_buffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+}
+
+bool
+TrajectoryBuffer::load(const std::shared_ptr<SimulationHistory> history,
+                       qint64 memory_budget)
+{
+    Q_ASSERT(history != nullptr);
+    Q_ASSERT(memory_budget > 0);
+    simulation_history = history;
+    // QOpenGLBuffer takes the sizes and offsets as int
+    this->memory_budget = std::min<qint64>(memory_budget, INT_MAX);
+    capacity = 0;
+    uploaded = 0;
+    uploaded_bytes = 0;
+    revision = history->revision();
+    return update();
+}
+
+bool
+TrajectoryBuffer::update()
+{
+    if (!simulation_history) return false;
+    const unsigned size = simulation_history->historySize();
+    if (simulation_history->revision() != revision) {
+        // the number of bodies might have changed too
+        revision = simulation_history->revision();
+        uploaded = 0;
+        capacity = 0;
+    }
+    if (size == uploaded) return true;
+    if (size > capacity) {
+        const qint64 vertex_bytes = qint64(VERTEX_SIZE) * sizeof(GLfloat)
+            * std::max(simulation_history->universeSize(), 1u);
+        const qint64 max_capacity = memory_budget / vertex_bytes;
+        if (size > max_capacity) {
+            clear();
+            return false;
+        }
+        reserve(std::min<qint64>(
+            std::max(std::max(size, 2 * capacity), MIN_CAPACITY),
+            max_capacity));
+    } else {
+        upload(uploaded);
+    }
+    uploaded = size;
+    return true;
+}
+
+void
+TrajectoryBuffer::reserve(unsigned vertices)
+{
+    const qint64 bytes = qint64(simulation_history->universeSize())
+        * vertices * VERTEX_SIZE * sizeof(GLfloat);
+    Q_ASSERT(bytes <= memory_budget);
+    capacity = vertices;
+    vertex_buffer.bind();
+    vertex_buffer.allocate(int(bytes));
+    vertex_buffer.release();
+    upload(0);
+}
+
+void
+TrajectoryBuffer::upload(unsigned from)
+{
+    const unsigned count = simulation_history->historySize() - from;
+    vertex_buffer.bind();
+    for (unsigned i = 0; i < simulation_history->universeSize(); i++) {
+        const PositionSpan data =
+            simulation_history->bodyPositions(i).subspan(from, count);
+        const qint64 offset = (qint64(i) * capacity + from) * VERTEX_SIZE
+            * sizeof(GLfloat);
+        const qint64 bytes = qint64(data.size()) * sizeof(GLfloat);
+        Q_ASSERT(offset + bytes <= memory_budget);
+        vertex_buffer.write(int(offset), data.data(), int(bytes));
+        uploaded_bytes += bytes;
+    }
+    vertex_buffer.release();
+}
+
+void
+TrajectoryBuffer::clear()
+{
+    simulation_history.reset();
+    capacity = 0;
+    uploaded = 0;
+    vertex_buffer.bind();
+    vertex_buffer.allocate(0);
+    vertex_buffer.release();
+}
+
+unsigned
+TrajectoryBuffer::draw(QOpenGLShaderProgram *program,
+                       unsigned from_index, unsigned until_index,
+                       const char* shader_variable)
+{
+    if (uploaded == 0) return 0;
+    until_index = std::min(until_index, uploaded - 1);
+    if (from_index >= until_index) return 0;
+
+    firsts.clear();
+    counts.clear();
+    for (unsigned i = 0; i < simulation_history->universeSize(); i++) {
+        firsts.push_back(i * capacity + from_index);
+        counts.push_back(until_index - from_index + 1);
+    }
+
+    vertex_buffer.bind();
+    program->enableAttributeArray(shader_variable);
+    program->setAttributeBuffer(shader_variable, GL_FLOAT, 0, VERTEX_SIZE);
+    vertex_buffer.release();
+    return multi_draw.draw(GL_LINE_STRIP, firsts, counts);
+}
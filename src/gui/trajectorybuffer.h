@@ -0,0 +1,133 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+
+/**
+ * @file
+ */
+#ifndef __TRAJECTORY_BUFFER_H__
+#define __TRAJECTORY_BUFFER_H__
+
+#include <memory>
+#include <vector>
+#include <QOpenGLBuffer>
+#include "gui/multidraw.h"
+#include "simulationhistory.h"
+
+
+class QOpenGLShaderProgram;
+
+/** Copy of all the positions saved in the simulation history, kept in one
+ * OpenGL buffer.
+ *
+ * Positions are uploaded only once, as they are saved, and trajectories for
+ * any window of the history are drawn by changing the offsets and counts of
+ * the draw call, so rewinding or scrubbing through the history doesn't copy
+ * anything. Every body has a segment with the same capacity; when the history
+ * outgrows it, the buffer is reallocated with twice the capacity.
+ *
+ * The buffer grows together with the history, but never over the memory
+ * budget given to load(). Once the history doesn't fit into it, update()
+ * fails and the trajectories have to be drawn by OrbitBuffer instead.
+ */
+class TrajectoryBuffer
+{
+public:
+    TrajectoryBuffer() = default;
+
+    /** Call this in initializeGL() or the equivalent - it assumes that the
+     * OpenGL context is bound, so it has to be separate from the constructor.
+     */
+    void initialize();
+
+    /// Default memory budget of the buffer, in bytes.
+    static const qint64 DEFAULT_MEMORY_BUDGET = 512 << 20;  // 512 MiB
+
+    /** Forget all the uploaded positions and copy from this history from now
+     * on. Assumes that the OpenGL context is bound.
+     *
+     * @param memory_budget: how many bytes can the buffer take at most, it is
+     *      also limited by the largest size QOpenGLBuffer can allocate
+     * @return false if the history doesn't fit into the budget, see update()
+     */
+    bool load(const std::shared_ptr<SimulationHistory> history,
+              qint64 memory_budget = DEFAULT_MEMORY_BUDGET);
+
+    /** Upload the positions saved since the last call. If some states were
+     * removed from the history in the meantime, everything is uploaded again.
+     * Assumes that the OpenGL context is bound.
+     *
+     * @return false if the history doesn't fit into the memory budget; the
+     *      buffer is then freed and forgets the history until the next load()
+     */
+    bool update();
+
+    /** Draw line strips of all the bodies between the saved states
+     * `from_index` and `until_index` (including both), limited to what was
+     * already uploaded.
+     *
+     * @param shader_variable: name of the input variable to the vertex shader
+     *      with positions of the vertices
+     * @return number of the issued draw calls
+     */
+    unsigned draw(QOpenGLShaderProgram *program,
+              unsigned from_index, unsigned until_index,
+              const char* shader_variable = "vertex");
+
+    /// How many bytes were written into the buffer since it was loaded.
+    unsigned long uploadedBytes() const {
+        return uploaded_bytes;
+    }
+
+    /// How many saved states are available on the GPU.
+    unsigned size() const {
+        return uploaded;
+    }
+
+private:
+    Q_DISABLE_COPY(TrajectoryBuffer)
+
+    /// Reallocate the buffer so that every body can store `vertices`
+    /// positions, uploading everything again.
+    void reserve(unsigned vertices);
+    /// Free the buffer and forget the history.
+    void clear();
+    /// Upload the positions of all the bodies from the vertex `from` until
+    /// the end of the history.
+    void upload(unsigned from);
+
+    QOpenGLBuffer vertex_buffer;
+    std::shared_ptr<SimulationHistory> simulation_history;
+    MultiDraw multi_draw;
+    /// Limit on the size of the buffer, in bytes.
+    qint64 memory_budget = DEFAULT_MEMORY_BUDGET;
+
+    /// How many vertices can the segment of every body store.
+    unsigned capacity = 0;
+    /// How many saved states were uploaded.
+    unsigned uploaded = 0;
+    /// SimulationHistory::revision when the positions were uploaded.
+    unsigned long revision = 0;
+    unsigned long uploaded_bytes = 0;
+
+    std::vector<GLint> firsts;
+    std::vector<GLsizei> counts;
+};
+
+#endif  // __TRAJECTORY_BUFFER_H__
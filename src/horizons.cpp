@@ -0,0 +1,141 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ */
+
+#include "horizons.h"
+
+#include <algorithm>
+#include <QFile>
+#include <QStringList>
+#include "projectparser.h"
+#include "exceptions.h"
+
+namespace parser
+{
+namespace
+{
+/// The time is matched exactly if it is closer to a row than this, in days.
+const physics::DOUBLE JULIAN_DATE_EPSILON = 1e-8;
+
+/// Julian date of 1970-01-01T00:00:00.
+const physics::DOUBLE UNIX_EPOCH_JULIAN_DATE = 2440587.5;
+
+const physics::DOUBLE METERS_PER_KM = 1000;
+}  // namespace
+
+std::vector<StateVector> readHorizonsTable(const QString& file_name)
+{
+    QFile file(file_name);
+    if(!file.open(QFile::ReadOnly | QFile::Text)) {
+        throw Exception("Can't read file " + file_name + ": "
+                        + file.errorString());
+    }
+
+    std::vector<StateVector> table;
+    while(!file.atEnd()) {
+        const QString line = QString::fromLatin1(file.readLine()).trimmed();
+        if(line.startsWith("$$EOE"))
+            break;
+        const QStringList columns = line.split(",");
+        if(columns.size() < 8)
+            continue;
+        bool ok;
+        StateVector state;
+        state.julian_date = columns[0].toDouble(&ok);
+        if(!ok)
+            continue;
+        for(int i = 0; i < 3; i++) {
+            bool position_ok, velocity_ok;
+            state.position[i] = columns[2 + i].toDouble(&position_ok)
+                                * METERS_PER_KM;
+            state.velocity[i] = columns[5 + i].toDouble(&velocity_ok)
+                                * METERS_PER_KM;
+            if(!position_ok || !velocity_ok) {
+                throw Exception("Invalid state vector at JDCT "
+                                + columns[0].trimmed() + " in "
+                                + file_name);
+            }
+        }
+        table.push_back(state);
+    }
+    if(table.empty())
+        throw Exception("No state vectors in " + file_name);
+
+    std::stable_sort(table.begin(), table.end(),
+                     [](const StateVector& a, const StateVector& b) {
+        return a.julian_date < b.julian_date;
+    });
+    return table;
+}
+
+StateVector horizonsState(const std::vector<StateVector>& table,
+                          physics::DOUBLE julian_date)
+{
+    Q_ASSERT(!table.empty());
+    if(julian_date < table.front().julian_date - JULIAN_DATE_EPSILON
+            || julian_date > table.back().julian_date + JULIAN_DATE_EPSILON) {
+        throw Exception(QString("The time JDCT %1 is outside of the table,"
+                                " which is from %2 to %3")
+                        .arg(double(julian_date), 0, 'f', 6)
+                        .arg(double(table.front().julian_date), 0, 'f', 6)
+                        .arg(double(table.back().julian_date), 0, 'f', 6));
+    }
+    auto next = std::lower_bound(table.begin(), table.end(), julian_date,
+                                 [](const StateVector& s, physics::DOUBLE t) {
+        return s.julian_date < t;
+    });
+    if(next != table.end()
+            && next->julian_date - julian_date < JULIAN_DATE_EPSILON)
+        return *next;
+    if(next == table.begin() || next == table.end())
+        return next == table.begin() ? table.front() : table.back();
+    const StateVector& previous = *(next - 1);
+    if(julian_date - previous.julian_date < JULIAN_DATE_EPSILON)
+        return previous;
+
+    // cubic Hermite interpolation on s in [0, 1]
+    const physics::DOUBLE h = (next->julian_date - previous.julian_date)
+                              * SECONDS_PER_DAY;
+    const physics::DOUBLE s = (julian_date - previous.julian_date)
+                              / (next->julian_date - previous.julian_date);
+    const physics::DOUBLE s2 = s * s, s3 = s2 * s;
+    const physics::Vector& p0 = previous.position;
+    const physics::Vector& p1 = next->position;
+    const physics::Vector m0 = previous.velocity * h;
+    const physics::Vector m1 = next->velocity * h;
+
+    StateVector state;
+    state.julian_date = julian_date;
+    state.position = p0 * (2 * s3 - 3 * s2 + 1) + m0 * (s3 - 2 * s2 + s)
+                     + p1 * (-2 * s3 + 3 * s2) + m1 * (s3 - s2);
+    state.velocity = (p0 * (6 * s2 - 6 * s) + m0 * (3 * s2 - 4 * s + 1)
+                      + p1 * (-6 * s2 + 6 * s) + m1 * (3 * s2 - 2 * s)) / h;
+    return state;
+}
+
+physics::DOUBLE julianDate(const QDateTime& date_time)
+{
+    return UNIX_EPOCH_JULIAN_DATE
+           + physics::DOUBLE(date_time.toMSecsSinceEpoch())
+             / (SECONDS_PER_DAY * 1000);
+}
+}  // namespace
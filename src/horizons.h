@@ -0,0 +1,67 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ * Import of state vectors from the JPL HORIZONS tables.
+ */
+
+#ifndef __HORIZONS_H__
+#define __HORIZONS_H__
+
+#include <vector>
+#include <QString>
+#include <QDateTime>
+#include "physics/vector.h"
+
+namespace parser
+{
+/// Position and velocity of a body at one moment, in meters and seconds.
+struct StateVector {
+    /// Julian date in coordinate time (JDCT).
+    physics::DOUBLE julian_date = 0;
+    physics::Vector position;
+    physics::Vector velocity;
+};
+
+/**
+ * Read a table of state vectors exported from HORIZONS as CSV, like the ones
+ * in `data/NASA`. Each row has the JDCT, the calendar date, the x, y, z
+ * position in km and the velocity in km/s. Lines which don't start with a
+ * number are skipped, the table ends at the `$$EOE` marker if there is one.
+ * @return the rows ordered by time, converted to meters and seconds
+ * @throw Exception if the file can't be read or contains no rows
+ */
+std::vector<StateVector> readHorizonsTable(const QString& file_name);
+
+/**
+ * The state of the body from the table at the given time. If the time falls
+ * between two rows, the position and velocity are interpolated by a cubic
+ * Hermite polynomial, which uses both the positions and the velocities.
+ * @throw Exception if the time is outside of the table
+ */
+StateVector horizonsState(const std::vector<StateVector>& table,
+                          physics::DOUBLE julian_date);
+
+/// Julian date of the moment, the time is taken as it is, without any
+/// conversion between UTC and coordinate time.
+physics::DOUBLE julianDate(const QDateTime& date_time);
+}  // namespace
+
+#endif  // __HORIZONS_H__
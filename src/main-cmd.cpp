@@ -23,7 +23,7 @@
  */
 
 #include <iostream>
-#include <iomanip>
+#include <fstream>
 #include <QCoreApplication>
 #include <QString>
 
@@ -31,18 +31,14 @@
 #include "projectparser.h"
 #include "physics/simulationtime.h"
 #include "algorithms/factory.h"
+#include "output/factory.h"
+#include "output/asyncwriter.h"
+#include "output/compression.h"
 #include "exceptions.h"
 
-using std::cout;
 using std::cerr;
 using std::endl;
 
-void printComment(const physics::UniverseModel& universe);
-void printStep(const physics::DOUBLE time,
-               const physics::UniverseModel& universe,
-               const parser::ProjectSettings& settings,
-               const physics::Vector& center);
-
 int main(int argc, char *argv[])
 {
     QCoreApplication app(argc, argv);
@@ -65,25 +61,62 @@ int main(int argc, char *argv[])
         physics::DOUBLE TOTAL_MASS = 0;
         for(const auto& body : universe) TOTAL_MASS += body.mass;
 
-        printComment(universe);
+        // the units are linear, so they are converted by a single division
+        output::Units units;
+        units.time_divisor = parser::convertUnits(1, settings.time_unit,
+                                                  parser::TimeUnit::SEC);
+        units.length_divisor = parser::convertUnits(1, settings.length_unit,
+                                                    parser::LengthUnit::METER);
+        units.time_name = parser::unitName(settings.time_unit).toStdString();
+        units.length_name =
+            parser::unitName(settings.length_unit).toStdString();
+
+        std::ios::sync_with_stdio(false);
+        std::ofstream file;
+        if(!arguments.output_file.isEmpty()) {
+            file.open(arguments.output_file.toStdString(),
+                      std::ios::out | std::ios::trunc | std::ios::binary);
+            if(!file)
+                throw Exception("Could not open the output file "
+                                + arguments.output_file);
+        }
+        std::ostream& stream = file.is_open() ? file : std::cout;
+        std::unique_ptr<output::CompressingBuffer> compressor;
+        std::unique_ptr<std::ostream> compressed;
+        if(arguments.compress) {
+            compressor.reset(new output::CompressingBuffer(&stream));
+            compressed.reset(new std::ostream(compressor.get()));
+        }
+        std::ostream *target = compressed ? compressed.get() : &stream;
+        // the results are formatted, compressed and written in another
+        // thread
+        output::AsyncWriter writer(output::factory(arguments.output_format,
+                                                   target,
+                                                   steps / save_state_step + 1,
+                                                   units));
+        writer.writeHeader(universe);
         // main computation
         for(unsigned i = 0; i <= steps; i++) {
             // print simulation state
             if(i % save_state_step == 0) {
+                physics::Vector center;
                 if(!arguments.center_to_barycenter) {
-                    printStep(time.time(), universe, settings,
-                              universe[arguments.center_body_index].position);
+                    center = universe[arguments.center_body_index].position;
                 } else {
                     physics::Vector sum;
                     for(const auto& body : universe) {
                         sum += body.position * body.mass;
                     }
-                    printStep(time.time(), universe, settings, sum/TOTAL_MASS);
+                    center = sum/TOTAL_MASS;
                 }
+                writer.writeStep(time.time(), universe, center);
             }
             algorithm->computeStep(&universe, time.timeStep());
             time.updateTime();
         }
+        writer.flush();
+        if(compressor)
+            compressor->finish();
     } catch(const Exception& e) {
         cerr << "ERROR: " << e.what() << endl;
         return EXIT_FAILURE;
@@ -93,29 +126,3 @@ int main(int argc, char *argv[])
     }
     return EXIT_SUCCESS;
 }
-
-void printComment(const physics::UniverseModel& universe)
-{
-    cout << "# time";
-    for(const auto& body : universe) {
-        cout << " " << qPrintable(body.name) << "_x";
-        cout << " " << qPrintable(body.name) << "_y";
-        cout << " " << qPrintable(body.name) << "_z";
-    }
-    cout << endl;
-}
-
-void printStep(const physics::DOUBLE time,
-               const physics::UniverseModel& universe,
-               const parser::ProjectSettings& settings,
-               const physics::Vector& center)
-{
-    cout << convertUnits(time, parser::TimeUnit::SEC, settings.time_unit);
-    for(const auto& body : universe) {
-        cout << std::setprecision(15) << " "
-             << parser::convertUnits(body.position - center,
-                                     parser::LengthUnit::METER,
-                                     settings.length_unit);
-    }
-    cout << endl;
-}
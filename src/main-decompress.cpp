@@ -0,0 +1,68 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ * Entry point for the tool decompressing the output of nsim-cmd.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QString>
+
+#include "output/compression.h"
+#include "exceptions.h"
+
+using std::cerr;
+using std::endl;
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("NSim");
+    QCoreApplication::setApplicationVersion("1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Decompress the results written by"
+                                     " nsim-cmd --compress and print them.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("file",
+        QCoreApplication::translate("main",
+        "Compressed file, the standard input is read if not given."));
+    parser.process(app);
+
+    try {
+        std::ios::sync_with_stdio(false);
+        std::ifstream file;
+        if(!parser.positionalArguments().isEmpty()) {
+            const QString name = parser.positionalArguments().first();
+            file.open(name.toStdString(), std::ios::in | std::ios::binary);
+            if(!file)
+                throw Exception("Could not open the file " + name);
+        }
+        output::decompress(file.is_open() ? &file : &std::cin, &std::cout);
+    } catch(const Exception& e) {
+        cerr << "ERROR: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
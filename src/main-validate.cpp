@@ -0,0 +1,310 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ * Entry point for the validation of the algorithms against the ephemerides
+ * from JPL HORIZONS.
+ *
+ * The universe from the project file is integrated by each of the chosen
+ * algorithms and time steps. In regular intervals, the positions of the
+ * bodies imported by the `<horizons>` tag are compared with their tables.
+ * For every comparison, one row of CSV is written with the wall time and
+ * the number of force evaluations spent so far and the position error. The
+ * last row of each run is one point of the work-precision diagram.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <memory>
+#include <cmath>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QString>
+
+#include "projectparser.h"
+#include "horizons.h"
+#include "algorithms/factory.h"
+#include "exceptions.h"
+
+using std::cerr;
+using std::endl;
+
+/// Default length of the validation in days.
+static const double DEFAULT_DAYS = 365;
+
+/// Default interval between the comparisons in days.
+static const double DEFAULT_INTERVAL = 1;
+
+/// Default time steps in seconds.
+static const char DEFAULT_STEPS[] = "3600,21600,86400";
+
+/// Reference table of a body and its index in the universe.
+struct Reference {
+    std::size_t body;
+    std::vector<parser::StateVector> table;
+};
+
+/// Position error of the compared bodies at one moment.
+struct Error {
+    physics::DOUBLE max = 0;
+    physics::DOUBLE rms = 0;
+    QString worst_body;
+};
+
+static std::vector<algorithms::Type> parseAlgorithms(const QString& text)
+{
+    std::vector<algorithms::Type> result;
+    if(text.isEmpty()) {
+        for(unsigned i = 0; i < algorithms::shortTypeName.size(); ++i)
+            result.push_back((algorithms::Type) i);
+        return result;
+    }
+    for(const QString& name : text.split(",")) {
+        bool valid = false;
+        for(unsigned i = 0; i < algorithms::shortTypeName.size(); ++i) {
+            if(name.trimmed() == algorithms::shortTypeName[i]) {
+                valid = true;
+                result.push_back((algorithms::Type) i);
+                break;
+            }
+        }
+        if(!valid)
+            throw Exception("Unknown algorithm " + name);
+    }
+    return result;
+}
+
+static std::vector<double> parseSteps(const QString& text)
+{
+    std::vector<double> result;
+    for(const QString& step : text.split(",")) {
+        bool ok;
+        result.push_back(step.toDouble(&ok));
+        if(!ok || result.back() <= 0)
+            throw Exception("Invalid time step " + step);
+    }
+    return result;
+}
+
+static double parseDays(const QString& text, const char *option)
+{
+    bool ok;
+    const double days = text.toDouble(&ok);
+    if(!ok || days <= 0)
+        throw Exception(QString("Invalid value of --") + option + " - "
+                        + text);
+    return days;
+}
+
+/**
+ * Compare the positions relative to the center body with the tables. The
+ * tables in data/NASA are centered to the Sun, so the center should be the
+ * Sun, or a body which has a table too.
+ */
+static Error compare(const physics::UniverseModel& universe,
+                     const std::vector<Reference>& references,
+                     std::size_t center, physics::DOUBLE julian_date)
+{
+    physics::Vector reference_center;
+    for(const auto& reference : references) {
+        if(reference.body == center)
+            reference_center = parser::horizonsState(reference.table,
+                                                     julian_date).position;
+    }
+    Error error;
+    unsigned count = 0;
+    for(const auto& reference : references) {
+        if(reference.body == center)
+            continue;
+        const physics::Vector expected =
+            parser::horizonsState(reference.table, julian_date).position
+            - reference_center;
+        const physics::DOUBLE distance = physics::abs(
+            universe[reference.body].position - universe[center].position
+            - expected);
+        if(distance >= error.max) {
+            error.max = distance;
+            error.worst_body = universe[reference.body].name;
+        }
+        error.rms += distance * distance;
+        count++;
+    }
+    if(count > 0)
+        error.rms = std::sqrt(error.rms / count);
+    return error;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("NSim");
+    QCoreApplication::setApplicationVersion("1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compare the algorithms with the"
+                                     " ephemerides from JPL HORIZONS and"
+                                     " print the error, wall time and force"
+                                     " evaluations in CSV format.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("file",
+        QCoreApplication::translate("main",
+        "Project file, the bodies with a <horizons> tag are compared with"
+        " their tables. Positions are relative to the visual center."));
+    parser.addOptions({
+        {   {"a", "algorithms"},
+            QCoreApplication::translate("main",
+            "Comma separated short names of the algorithms. All of them are"
+            " compared by default."),
+            QCoreApplication::translate("main", "algorithms")
+        },
+        {   {"s", "steps"},
+            QCoreApplication::translate("main",
+            "Comma separated time steps in seconds. Default is ")
+            + DEFAULT_STEPS + ".",
+            QCoreApplication::translate("main", "seconds")
+        },
+        {   {"t", "time"},
+            QCoreApplication::translate("main",
+            "Length of the simulation in days. Default is ")
+            + QString::number(DEFAULT_DAYS) + ".",
+            QCoreApplication::translate("main", "days")
+        },
+        {   {"i", "interval"},
+            QCoreApplication::translate("main",
+            "Interval between the comparisons in days. Default is ")
+            + QString::number(DEFAULT_INTERVAL) + ".",
+            QCoreApplication::translate("main", "days")
+        },
+        {   {"o", "output"},
+            QCoreApplication::translate("main",
+            "Write the results to the file instead of the standard output."),
+            QCoreApplication::translate("main", "file")
+        }
+    });
+    parser.process(app);
+
+    try {
+        if(parser.positionalArguments().isEmpty())
+            throw Exception("No input file name specified.");
+        const auto types = parseAlgorithms(parser.value("algorithms"));
+        const auto steps = parseSteps(parser.isSet("steps")
+                                      ? parser.value("steps")
+                                      : QString(DEFAULT_STEPS));
+        const double days = parser.isSet("time")
+                            ? parseDays(parser.value("time"), "time")
+                            : DEFAULT_DAYS;
+        const double interval = parser.isSet("interval")
+                                ? parseDays(parser.value("interval"),
+                                            "interval")
+                                : DEFAULT_INTERVAL;
+
+        parser::ProjectParser project(parser.positionalArguments().first());
+        const auto initial_universe = project.getUniverseModel();
+        const std::size_t center = project.getSettings().visual_center;
+        const auto& sources = project.getHorizonsSources();
+        if(sources.empty())
+            throw Exception("No bodies with a <horizons> tag to compare.");
+
+        // all the bodies have to start at the same time
+        const physics::DOUBLE epoch = sources.front().julian_date;
+        std::vector<Reference> references;
+        for(const auto& source : sources) {
+            if(source.julian_date != epoch)
+                throw Exception("The bodies are imported at different"
+                                " times.");
+            references.push_back({source.body,
+                                  parser::readHorizonsTable(source.file)});
+            if(references.back().table.back().julian_date < epoch + days)
+                throw Exception("The table " + source.file + " ends before"
+                                " the end of the validation.");
+        }
+
+        std::ofstream file;
+        if(parser.isSet("output")) {
+            file.open(parser.value("output").toStdString(),
+                      std::ios::out | std::ios::trunc);
+            if(!file)
+                throw Exception("Could not open the output file "
+                                + parser.value("output"));
+        }
+        std::ostream& output = file.is_open() ? file : std::cout;
+        output.precision(10);
+        output << "algorithm,time step [s],time [s],wall time [s],"
+               << "force evaluations,max error [m],rms error [m],worst body\n";
+
+        for(const auto type : types) {
+            for(const double step : steps) {
+                auto universe = initial_universe;
+                auto algorithm = algorithms::factory(type);
+                const unsigned long total = std::lround(
+                    days * parser::SECONDS_PER_DAY / step);
+                const unsigned long compare_step = std::max(1l, std::lround(
+                    interval * parser::SECONDS_PER_DAY / step));
+                QElapsedTimer timer;
+                qint64 wall_time = 0;
+                Error error;
+                try {
+                    for(unsigned long i = 1; i <= total; i++) {
+                        // only the integration is measured
+                        timer.start();
+                        algorithm->computeStep(&universe, step);
+                        wall_time += timer.nsecsElapsed();
+                        if(i % compare_step != 0 && i != total)
+                            continue;
+                        const physics::DOUBLE time = i * step;
+                        error = compare(
+                            universe, references, center,
+                            epoch + time / parser::SECONDS_PER_DAY);
+                        output << algorithms::shortTypeName[type]
+                                  .toStdString() << ','
+                               << step << ',' << double(time) << ','
+                               << wall_time * 1e-9 << ','
+                               << algorithm->forceEvaluations() << ','
+                               << double(error.max) << ','
+                               << double(error.rms) << ','
+                               << error.worst_body.toStdString() << '\n';
+                    }
+                } catch(const Exception& e) {
+                    // e.g. a crash of two bodies with a too large step
+                    cerr << algorithms::shortTypeName[type].toStdString()
+                         << ", step " << step << " s: " << e.what() << endl;
+                    continue;
+                }
+                cerr << algorithms::shortTypeName[type].toStdString()
+                     << ", step " << step << " s: max error "
+                     << double(error.max) << " m, "
+                     << wall_time * 1e-9 << " s, "
+                     << algorithm->forceEvaluations()
+                     << " force evaluations" << endl;
+            }
+        }
+        output.flush();
+        if(!output)
+            throw Exception("Could not write the results.");
+    } catch(const Exception& e) {
+        cerr << "ERROR: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
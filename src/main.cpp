@@ -22,9 +22,12 @@
  * Entry point for the GUI.
  */
 
+#include <iostream>
 #include <QtWidgets/QApplication>
 #include <QSurfaceFormat>
 #include "gui/mainwindow.h"
+#include "gui/headless.h"
+#include "exceptions.h"
 
 int main(int argc, char *argv[])
 {
@@ -37,6 +40,17 @@ int main(int argc, char *argv[])
     format.setSamples(4);
     QSurfaceFormat::setDefaultFormat(format);
 
+    try {
+        HeadlessOptions options;
+        if (parseHeadlessOptions(a, &options)) {
+            renderHeadless(options);
+            return EXIT_SUCCESS;
+        }
+    } catch(const Exception& e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
     MainWindow w;
     w.show();
     return a.exec();
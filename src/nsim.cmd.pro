@@ -7,7 +7,23 @@ CONFIG += console
 
 HEADERS +=  arguments.h\
             projectparser.h\
+            horizons.h\
+            bodytable.h\
+            output/types.h\
+            output/writer.h\
+            output/textwriter.h\
+            output/npywriter.h\
+            output/factory.h\
+            output/asyncwriter.h\
+            output/compression.h\
 
 SOURCES +=  main-cmd.cpp\
             projectparser.cpp\
+            horizons.cpp\
+            bodytable.cpp\
             arguments.cpp\
+            output/textwriter.cpp\
+            output/npywriter.cpp\
+            output/factory.cpp\
+            output/asyncwriter.cpp\
+            output/compression.cpp\
@@ -0,0 +1,10 @@
+# decompresses the output of nsim-cmd --compress
+TARGET = nsim-decompress
+include(../common.pri)
+
+CONFIG += console
+
+HEADERS +=  output/compression.h\
+
+SOURCES +=  main-decompress.cpp\
+            output/compression.cpp\
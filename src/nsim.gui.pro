@@ -7,12 +7,16 @@ QT += widgets opengl
 
 HEADERS +=  $$files(gui/*.h)\
             projectparser.h\
+            horizons.h\
+            bodytable.h\
             buffer.h\
             simulation.h\
             simulationhistory.h\
 
 SOURCES +=  $$files(gui/*.cpp)\
             projectparser.cpp\
+            horizons.cpp\
+            bodytable.cpp\
             main.cpp\
             simulation.cpp\
             simulationhistory.cpp\
@@ -0,0 +1,15 @@
+# compares the algorithms with the ephemerides from JPL HORIZONS
+TARGET = nsim-validate
+include(../common.pri)
+
+QT += xml
+CONFIG += console
+
+HEADERS +=  projectparser.h\
+            horizons.h\
+            bodytable.h\
+
+SOURCES +=  main-validate.cpp\
+            projectparser.cpp\
+            horizons.cpp\
+            bodytable.cpp\
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ */
+
+#include "output/asyncwriter.h"
+
+#include <algorithm>
+#include <QMutexLocker>
+#include "exceptions.h"
+
+namespace output
+{
+const unsigned AsyncWriter::BUFFER_COUNT;
+const std::size_t AsyncWriter::BLOCK_SIZE;
+
+AsyncWriter::AsyncWriter(std::unique_ptr<Writer> writer,
+                         std::size_t block_size)
+    : writer(std::move(writer)), block_size(block_size)
+{
+    Q_ASSERT(this->writer);
+}
+
+AsyncWriter::~AsyncWriter()
+{
+    {
+        QMutexLocker lock(&mutex);
+        if (!current.empty() && error.isEmpty())
+            queue.push_back(std::move(current));
+        finishing = true;
+        queue_not_empty.wakeAll();
+    }
+    wait();
+}
+
+void
+AsyncWriter::writeHeader(const physics::UniverseModel& universe)
+{
+    Q_ASSERT(!isRunning());
+    writer->writeHeader(universe);
+    frame = universe;
+    step_width = 4 + 3 * universe.size();
+    const std::size_t steps = std::max<std::size_t>(
+        block_size / sizeof(physics::DOUBLE) / step_width, 1);
+    free_blocks.resize(BUFFER_COUNT - 1);
+    for (auto& block: free_blocks)
+        block.reserve(steps * step_width);
+    current.reserve(steps * step_width);
+    start();
+}
+
+void
+AsyncWriter::writeStep(physics::DOUBLE time,
+                       const physics::UniverseModel& universe,
+                       const physics::Vector& center)
+{
+    Q_ASSERT(universe.size() == frame.size());
+    current.push_back(time);
+    current.push_back(center[0]);
+    current.push_back(center[1]);
+    current.push_back(center[2]);
+    for(const auto& body : universe) {
+        current.push_back(body.position[0]);
+        current.push_back(body.position[1]);
+        current.push_back(body.position[2]);
+    }
+    if (current.size() + step_width > current.capacity())
+        queueBlock();
+}
+
+void
+AsyncWriter::flush()
+{
+    if (!current.empty())
+        queueBlock();
+    {
+        QMutexLocker lock(&mutex);
+        while ((!queue.empty() || writing) && error.isEmpty())
+            block_returned.wait(&mutex);
+        checkError();
+    }
+    // the thread is idle until the next block is queued
+    writer->flush();
+}
+
+void
+AsyncWriter::queueBlock()
+{
+    QMutexLocker lock(&mutex);
+    while (free_blocks.empty() && error.isEmpty())
+        block_returned.wait(&mutex);
+    checkError();
+    queue.push_back(std::move(current));
+    current = std::move(free_blocks.back());
+    free_blocks.pop_back();
+    queue_not_empty.wakeOne();
+}
+
+void
+AsyncWriter::checkError()
+{
+    if (!error.isEmpty())
+        throw Exception("Writing the output failed - " + error);
+}
+
+void
+AsyncWriter::run()
+{
+    while (true) {
+        Block block;
+        {
+            QMutexLocker lock(&mutex);
+            while (queue.empty() && !finishing)
+                queue_not_empty.wait(&mutex);
+            if (queue.empty())
+                return;
+            block = std::move(queue.front());
+            queue.pop_front();
+            writing = true;
+        }
+
+        // the slow part runs without the lock
+        QString message;
+        try {
+            for(std::size_t i = 0; i < block.size(); i += step_width) {
+                const physics::Vector center(block[i + 1], block[i + 2],
+                                             block[i + 3]);
+                for(std::size_t j = 0; j < frame.size(); j++) {
+                    frame[j].position.set(block[i + 4 + 3 * j],
+                                          block[i + 5 + 3 * j],
+                                          block[i + 6 + 3 * j]);
+                }
+                writer->writeStep(block[i], frame, center);
+            }
+        } catch(const std::exception& e) {
+            message = e.what();
+        }
+
+        QMutexLocker lock(&mutex);
+        writing = false;
+        if (!message.isEmpty()) {
+            error = message;
+            queue.clear();
+            block_returned.wakeAll();
+            return;
+        }
+        block.clear();
+        free_blocks.push_back(std::move(block));
+        block_returned.wakeAll();
+    }
+}
+
+}  // namespace output
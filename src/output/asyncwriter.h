@@ -0,0 +1,121 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ * Writer running in its own thread, so the output overlaps the computation.
+ */
+
+#ifndef __OUTPUT_ASYNCWRITER_H__
+#define __OUTPUT_ASYNCWRITER_H__
+
+#include <deque>
+#include <memory>
+#include <vector>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QString>
+#include "output/writer.h"
+
+namespace output
+{
+/**
+ * Passes the steps to another writer in a separate thread.
+ *
+ * The steps are copied into blocks of memory and a full block is handed over
+ * to the thread, which formats and writes it while the simulation goes on.
+ * There are AsyncWriter::BUFFER_COUNT blocks - one is being filled, the
+ * others are waiting for the thread or being written. When all of them are
+ * in use, AsyncWriter::writeStep blocks until the thread returns one, so a
+ * slow disk or pipe stalls the simulation only when the buffers run out.
+ *
+ * Errors from the thread are thrown from the next call in the caller thread.
+ */
+class AsyncWriter : public QThread, public Writer
+{
+public:
+    /// Number of blocks cycled between the caller and the thread.
+    static const unsigned BUFFER_COUNT = 3;
+
+    /// Default size of one block, in bytes.
+    static const std::size_t BLOCK_SIZE = 1 << 20;
+
+    /**
+     * @param writer writer used in the thread; the AsyncWriter takes over
+     *      and calls it only from one thread at a time
+     * @param block_size how much data is collected before it is written
+     */
+    explicit AsyncWriter(std::unique_ptr<Writer> writer,
+                         std::size_t block_size = BLOCK_SIZE);
+
+    /// Writes all the steps and stops the thread, errors are ignored.
+    ~AsyncWriter();
+
+    /// Writes the header right away and starts the thread.
+    void writeHeader(const physics::UniverseModel& universe) override;
+
+    /// @throw Exception if writing some of the previous steps failed
+    void writeStep(physics::DOUBLE time,
+                   const physics::UniverseModel& universe,
+                   const physics::Vector& center) override;
+
+    /// Waits until the thread writes all the steps, then flushes the
+    /// wrapped writer.
+    void flush() override;
+
+protected:
+    void run() override;
+
+private:
+    typedef std::vector<physics::DOUBLE> Block;
+
+    /// Hand the block that is being filled over to the thread.
+    void queueBlock();
+
+    /// Throw if the thread failed, the mutex has to be locked.
+    void checkError();
+
+    std::unique_ptr<Writer> writer;
+    std::size_t block_size;
+    /// Copy of the universe given to the wrapped writer, with the positions
+    /// of the step that is being written.
+    physics::UniverseModel frame;
+    /// Number of values per step - the time, the center and the positions.
+    std::size_t step_width = 0;
+    /// Block that is being filled by the caller.
+    Block current;
+
+    QMutex mutex;
+    QWaitCondition queue_not_empty;
+    QWaitCondition block_returned;
+    /// Full blocks waiting for the thread.
+    std::deque<Block> queue;
+    /// Empty blocks ready to be filled.
+    std::vector<Block> free_blocks;
+    /// Is the thread writing a block right now?
+    bool writing = false;
+    bool finishing = false;
+    /// First error that happened in the thread.
+    QString error;
+};
+
+}  // namespace output
+
+#endif  // __OUTPUT_ASYNCWRITER_H__
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ */
+
+#include "output/compression.h"
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <QByteArray>
+#include <QtGlobal>
+#include "exceptions.h"
+
+namespace output
+{
+namespace
+{
+const char MAGIC[] = "NSIMZ01\n";
+const std::size_t MAGIC_LENGTH = sizeof(MAGIC) - 1;
+
+void writeLength(std::ostream *output, std::uint32_t length)
+{
+    char bytes[4];
+    for(unsigned i = 0; i < 4; i++)
+        bytes[i] = char((length >> (8 * i)) & 0xff);
+    output->write(bytes, 4);
+}
+}  // namespace
+
+const std::size_t CompressingBuffer::BLOCK_SIZE;
+
+CompressingBuffer::CompressingBuffer(std::ostream *output, int level,
+                                     std::size_t block_size)
+    : output(output), level(level), block(std::max<std::size_t>(block_size, 1))
+{
+    Q_ASSERT(output != nullptr);
+    Q_ASSERT(level >= -1 && level <= 9);
+    setp(block.data(), block.data() + block.size());
+    output->write(MAGIC, MAGIC_LENGTH);
+}
+
+CompressingBuffer::~CompressingBuffer()
+{
+    if (!finished && writeBlock()) {
+        writeLength(output, 0);
+        output->flush();
+    }
+}
+
+void
+CompressingBuffer::finish()
+{
+    Q_ASSERT(!finished);
+    const bool written = writeBlock();
+    finished = true;
+    writeLength(output, 0);
+    output->flush();
+    if (!written || !*output)
+        throw Exception("Could not write the compressed output.");
+}
+
+CompressingBuffer::int_type
+CompressingBuffer::overflow(int_type c)
+{
+    if (finished || !writeBlock())
+        return traits_type::eof();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int
+CompressingBuffer::sync()
+{
+    if (!writeBlock())
+        return -1;
+    output->flush();
+    return *output ? 0 : -1;
+}
+
+bool
+CompressingBuffer::writeBlock()
+{
+    const int length = pptr() - pbase();
+    if (length > 0) {
+        const QByteArray compressed = qCompress(
+            reinterpret_cast<const uchar*>(pbase()), length, level);
+        writeLength(output, compressed.size());
+        output->write(compressed.constData(), compressed.size());
+        setp(block.data(), block.data() + block.size());
+    }
+    return bool(*output);
+}
+
+void
+decompress(std::istream *input, std::ostream *output)
+{
+    char magic[MAGIC_LENGTH];
+    if (!input->read(magic, MAGIC_LENGTH)
+            || std::memcmp(magic, MAGIC, MAGIC_LENGTH) != 0)
+        throw Exception("The input isn't compressed NSim output.");
+
+    while (true) {
+        unsigned char bytes[4];
+        if (!input->read(reinterpret_cast<char*>(bytes), 4))
+            throw Exception("The compressed data is truncated.");
+        const std::uint32_t length = bytes[0] | bytes[1] << 8
+                                     | bytes[2] << 16
+                                     | std::uint32_t(bytes[3]) << 24;
+        if (length == 0)
+            break;
+        QByteArray compressed;
+        compressed.resize(length);
+        if (!input->read(compressed.data(), length))
+            throw Exception("The compressed data is truncated.");
+        const QByteArray data = qUncompress(compressed);
+        if (data.isEmpty())
+            throw Exception("The compressed data is corrupted.");
+        output->write(data.constData(), data.size());
+        if (!*output)
+            throw Exception("Could not write the decompressed output.");
+    }
+    output->flush();
+}
+
+}  // namespace output
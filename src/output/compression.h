@@ -0,0 +1,97 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ * Streaming compression of the simulation results.
+ */
+
+#ifndef __OUTPUT_COMPRESSION_H__
+#define __OUTPUT_COMPRESSION_H__
+
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+namespace output
+{
+/**
+ * Stream buffer which compresses everything written into it and passes it to
+ * another stream. The data is split into blocks compressed by zlib (using
+ * qCompress), so any amount of data can be compressed without keeping it in
+ * memory.
+ *
+ * The compressed stream starts with the magic string `NSIMZ01\n`, followed
+ * by frames with a 4 byte little-endian length and the compressed block of
+ * that length. A frame with the length 0 marks the end. It can be read with
+ * output::decompress or the `nsim-decompress` tool.
+ *
+ * The stream can't be seeked. Flushing the stream compresses the data
+ * collected so far into a smaller block, so everything written before the
+ * flush can be decompressed.
+ */
+class CompressingBuffer : public std::streambuf
+{
+public:
+    /// Default size of the uncompressed blocks, in bytes.
+    static const std::size_t BLOCK_SIZE = 1 << 20;
+
+    /**
+     * @param output where the compressed data is written, must outlive the
+     *      buffer
+     * @param level zlib compression level from 0 to 9, -1 is the default
+     * @param block_size how much data is compressed at once
+     */
+    explicit CompressingBuffer(std::ostream *output, int level = -1,
+                               std::size_t block_size = BLOCK_SIZE);
+
+    /// Finishes the stream, errors are ignored.
+    ~CompressingBuffer();
+
+    /**
+     * Compress the rest of the data and write the end of the stream. Nothing
+     * can be written afterwards.
+     * @throw Exception if the data could not be written
+     */
+    void finish();
+
+protected:
+    int_type overflow(int_type c) override;
+    int sync() override;
+
+private:
+    /// Compress and write the collected data, returns false on errors.
+    bool writeBlock();
+
+    std::ostream *output;
+    int level;
+    std::vector<char> block;
+    bool finished = false;
+};
+
+/**
+ * Decompress everything written through a CompressingBuffer.
+ * @throw Exception if the input isn't complete or valid compressed data
+ */
+void decompress(std::istream *input, std::ostream *output);
+
+}  // namespace output
+
+#endif  // __OUTPUT_COMPRESSION_H__
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ */
+
+#include "output/factory.h"
+
+#include "exceptions.h"
+#include "output/textwriter.h"
+#include "output/npywriter.h"
+
+
+std::unique_ptr<output::Writer>
+output::factory(const output::Format format, std::ostream *stream,
+                unsigned long long steps, const output::Units& units)
+{
+    std::unique_ptr<output::Writer> writer;
+    switch(format) {
+    case output::F_TEXT:
+        writer.reset(new output::TextWriter(stream, units));
+        break;
+    case output::F_NPY:
+        writer.reset(new output::NpyWriter(stream, steps,
+                                           output::NpyWriter::TIME_MAJOR,
+                                           units));
+        break;
+    case output::F_NPY_BODY_MAJOR:
+        writer.reset(new output::NpyWriter(stream, steps,
+                                           output::NpyWriter::BODY_MAJOR,
+                                           units));
+        break;
+    default:
+        throw Exception("Unknown output format");
+    }
+    return writer;
+}
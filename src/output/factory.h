@@ -0,0 +1,53 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ * Factory function to create a writer of a specified format.
+ */
+
+#ifndef __OUTPUTFACTORY_H__
+#define __OUTPUTFACTORY_H__
+
+#include <memory>
+#include <ostream>
+#include "output/types.h"
+#include "output/writer.h"
+
+/**
+ * @namespace output Writers of the simulation results
+ *
+ * The CLI passes the states of the universe that should be printed to a
+ * Writer, which stores them in the format chosen by the user.
+ */
+namespace output
+{
+/**
+ * Shortcut for getting the writer instance based on its format.
+ * @param stream where the results are written, must outlive the writer
+ * @param steps number of steps that will be written
+ * @param units units of the written values
+ */
+std::unique_ptr<output::Writer> factory(const output::Format format,
+                                        std::ostream *stream,
+                                        unsigned long long steps,
+                                        const output::Units& units);
+}
+
+#endif  // __OUTPUTFACTORY_H__
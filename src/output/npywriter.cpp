@@ -0,0 +1,217 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ */
+
+#include "output/npywriter.h"
+
+#include <cstdint>
+#include <algorithm>
+#include <set>
+#include <QtGlobal>
+#include "exceptions.h"
+
+namespace output
+{
+namespace
+{
+/// Alignment of the array data in the file.
+const std::size_t NPY_ALIGNMENT = 64;
+
+bool littleEndian()
+{
+    const std::uint16_t one = 1;
+    return *reinterpret_cast<const unsigned char*>(&one) == 1;
+}
+
+/// Python string literal with the given text.
+std::string quoted(const std::string& text)
+{
+    std::string result = "'";
+    for(char c : text) {
+        if(c == '\'' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+    return result + "'";
+}
+
+/// Field names of the bodies, made unique because NumPy requires it.
+std::vector<std::string> fieldNames(const physics::UniverseModel& universe)
+{
+    std::vector<std::string> names;
+    std::set<std::string> used = {"time"};
+    for(unsigned i = 0; i < universe.size(); i++) {
+        std::string name = universe[i].name.toStdString();
+        if(name.empty() || used.count(name) > 0)
+            name += "_" + std::to_string(i);
+        used.insert(name);
+        names.push_back(name);
+    }
+    return names;
+}
+
+/// Append the number to the string in little-endian order.
+void appendLittleEndian(std::string *text, std::uint32_t value,
+                        unsigned bytes)
+{
+    for(unsigned i = 0; i < bytes; i++)
+        *text += char((value >> (8 * i)) & 0xff);
+}
+}  // namespace
+
+const std::size_t NpyWriter::BLOCK_SIZE;
+
+NpyWriter::NpyWriter(std::ostream *output, unsigned long long steps,
+                     Layout layout, const Units& units,
+                     std::size_t block_size)
+    : output(output), steps(steps), layout(layout), units(units),
+      block_size(block_size)
+{
+    Q_ASSERT(output != nullptr);
+}
+
+NpyWriter::~NpyWriter()
+{
+    writeBlock();
+    output->flush();
+}
+
+std::string
+NpyWriter::header(const physics::UniverseModel& universe,
+                  unsigned long long steps, Layout layout,
+                  const Units& units)
+{
+    const std::string type = littleEndian() ? "'<f8'" : "'>f8'";
+    const std::string count = std::to_string(steps);
+    const bool body_major = layout == BODY_MAJOR;
+
+    std::string dict = "{'descr': [(("
+                       + quoted("time [" + units.time_name + "]") + ", "
+                       + quoted("time") + "), " + type
+                       + (body_major ? ", (" + count + ",)" : "") + ")";
+    for(const auto& name : fieldNames(universe)) {
+        dict += ", ((" + quoted(name + " position ["
+                                + units.length_name + "]")
+                + ", " + quoted(name) + "), " + type
+                + (body_major ? ", (" + count + ", 3)" : ", (3,)") + ")";
+    }
+    dict += "], 'fortran_order': False, 'shape': "
+            + (body_major ? std::string("()") : "(" + count + ",)") + ", }";
+
+    // version 1.0 has a 2 byte header length, 2.0 a 4 byte length and both
+    // allow only latin1, version 3.0 allows UTF-8 names
+    const bool ascii = std::all_of(dict.begin(), dict.end(), [](char c) {
+        return static_cast<unsigned char>(c) < 128;
+    });
+    const bool short_header = dict.size() + NPY_ALIGNMENT < 0xffff;
+    const char version = !ascii ? 3 : short_header ? 1 : 2;
+    const unsigned length_bytes = version == 1 ? 2 : 4;
+    const std::size_t prefix = 8 + length_bytes;
+    const std::size_t padded = (prefix + dict.size() + 1 + NPY_ALIGNMENT - 1)
+                               / NPY_ALIGNMENT * NPY_ALIGNMENT;
+    dict.append(padded - prefix - dict.size() - 1, ' ');
+    dict += '\n';
+
+    std::string result = "\x93NUMPY";
+    result += version;
+    result += char(0);
+    appendLittleEndian(&result, dict.size(), length_bytes);
+    return result + dict;
+}
+
+void
+NpyWriter::writeHeader(const physics::UniverseModel& universe)
+{
+    Q_ASSERT(written_steps == 0 && block.empty());
+    step_width = 1 + 3 * universe.size();
+    block.reserve(std::max<std::size_t>(block_size / sizeof(double)
+                                        / step_width, 1) * step_width);
+    const std::string text = header(universe, steps, layout, units);
+    output->write(text.data(), text.size());
+    data_start = output->tellp();
+    if (layout == BODY_MAJOR && data_start < 0)
+        throw Exception("The body-major layout needs a seekable output,"
+                        " use an uncompressed output file.");
+}
+
+void
+NpyWriter::writeStep(physics::DOUBLE time,
+                     const physics::UniverseModel& universe,
+                     const physics::Vector& center)
+{
+    Q_ASSERT(1 + 3 * universe.size() == step_width);
+    Q_ASSERT(written_steps + block.size() / step_width < steps);
+    block.push_back(time / units.time_divisor);
+    for(const auto& body : universe) {
+        const physics::Vector p = (body.position - center)
+                                  / units.length_divisor;
+        block.push_back(p[0]);
+        block.push_back(p[1]);
+        block.push_back(p[2]);
+    }
+    if (block.size() == block.capacity())
+        writeBlock();
+}
+
+void
+NpyWriter::flush()
+{
+    writeBlock();
+    output->flush();
+    if (!*output)
+        throw Exception("Could not write the output.");
+}
+
+void
+NpyWriter::writeBlock()
+{
+    if (block.empty())
+        return;
+    const std::size_t block_steps = block.size() / step_width;
+    if (layout == TIME_MAJOR) {
+        output->write(reinterpret_cast<const char*>(block.data()),
+                      block.size() * sizeof(double));
+    } else {
+        // every field is a contiguous array in the file, so the block is
+        // split into one part per field and each part is written in its place
+        std::vector<double> part(block_steps * 3);
+        std::streamoff field_start = data_start;
+        for(std::size_t field = 0; field <= step_width / 3; field++) {
+            // the time, then the coordinates of each body
+            const std::size_t width = field == 0 ? 1 : 3;
+            const std::size_t first = field == 0 ? 0 : 3 * field - 2;
+            for(std::size_t i = 0; i < block_steps; i++) {
+                for(std::size_t j = 0; j < width; j++)
+                    part[i * width + j] = block[i * step_width + first + j];
+            }
+            output->seekp(field_start + std::streamoff(written_steps * width
+                                                       * sizeof(double)));
+            output->write(reinterpret_cast<const char*>(part.data()),
+                          block_steps * width * sizeof(double));
+            field_start += steps * width * sizeof(double);
+        }
+    }
+    written_steps += block_steps;
+    block.clear();
+}
+
+}  // namespace output
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ * Binary output of the simulation in the NumPy `.npy` format.
+ */
+
+#ifndef __OUTPUT_NPYWRITER_H__
+#define __OUTPUT_NPYWRITER_H__
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "output/writer.h"
+
+namespace output
+{
+/**
+ * Writes the results as a NumPy file with a structured data type. There is
+ * a `time` field and one field with the x, y and z coordinates per body,
+ * named after the body. The fields are float64 and their titles contain
+ * the units, for example `"Earth position [km]"`.
+ *
+ * The data starts at a 64 byte boundary after the header, so the file can be
+ * memory-mapped without parsing, e.g. `numpy.load(file, mmap_mode='r')`, and
+ * `array['Earth']` is then the trajectory of Earth with the shape (steps, 3).
+ *
+ * The number of steps is stored in the header, so it has to be known when
+ * the writer is created and exactly that many steps have to be written.
+ */
+class NpyWriter : public Writer
+{
+public:
+    /// How the values are ordered in the file.
+    enum Layout {
+        /// One record with the time and all the positions per step, the
+        /// array has the shape (steps,).
+        TIME_MAJOR,
+        /// The times of all the steps, then the whole trajectory of the
+        /// first body, and so on. The array has the shape () and the fields
+        /// are sub-arrays of the shape (steps,) and (steps, 3).
+        BODY_MAJOR
+    };
+
+    /// Default size of the buffered steps, in bytes.
+    static const std::size_t BLOCK_SIZE = 1 << 20;
+
+    /**
+     * @param output binary stream where the file is written, must outlive
+     *      the writer and has to be seekable for the BODY_MAJOR layout
+     * @param steps number of steps that will be written
+     * @param layout order of the values in the file
+     * @param units units of the written values
+     * @param block_size how much data is collected before it is written
+     */
+    NpyWriter(std::ostream *output, unsigned long long steps,
+              Layout layout = TIME_MAJOR, const Units& units = Units(),
+              std::size_t block_size = BLOCK_SIZE);
+
+    /// Writes out the buffered steps, errors are ignored.
+    ~NpyWriter();
+
+    void writeHeader(const physics::UniverseModel& universe) override;
+    void writeStep(physics::DOUBLE time,
+                   const physics::UniverseModel& universe,
+                   const physics::Vector& center) override;
+    void flush() override;
+
+    /**
+     * The `.npy` header describing the universe, including the magic string
+     * and padding, see https://numpy.org/doc/stable/reference/generated/
+     * numpy.lib.format.html.
+     */
+    static std::string header(const physics::UniverseModel& universe,
+                              unsigned long long steps, Layout layout,
+                              const Units& units);
+
+private:
+    /// Pass the buffered steps to the stream.
+    void writeBlock();
+
+    std::ostream *output;
+    unsigned long long steps;
+    Layout layout;
+    Units units;
+    std::size_t block_size;
+    /// Number of values in one step - the time and the coordinates.
+    std::size_t step_width = 0;
+    /// Buffered steps, in the time-major order.
+    std::vector<double> block;
+    /// Number of steps passed to the stream.
+    unsigned long long written_steps = 0;
+    /// Where the array data starts in the stream.
+    std::streamoff data_start = 0;
+};
+
+}  // namespace output
+
+#endif  // __OUTPUT_NPYWRITER_H__
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ */
+
+#include "output/textwriter.h"
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <QtGlobal>
+#include "exceptions.h"
+
+namespace output
+{
+const std::size_t TextWriter::BLOCK_SIZE;
+const std::size_t TextWriter::MAX_NUMBER_LENGTH;
+
+TextWriter::TextWriter(std::ostream *output, const Units& units,
+                       std::size_t block_size)
+    : output(output), units(units),
+      block(std::max(block_size, MAX_NUMBER_LENGTH))
+{
+    Q_ASSERT(output != nullptr);
+}
+
+TextWriter::~TextWriter()
+{
+    if (used > 0) {
+        output->write(block.data(), used);
+        output->flush();
+    }
+}
+
+void
+TextWriter::writeHeader(const physics::UniverseModel& universe)
+{
+    std::string header = "# time";
+    for(const auto& body : universe) {
+        const std::string name = body.name.toStdString();
+        header += " " + name + "_x";
+        header += " " + name + "_y";
+        header += " " + name + "_z";
+    }
+    header += "\n";
+    append(header.data(), header.size());
+}
+
+void
+TextWriter::writeStep(physics::DOUBLE time,
+                      const physics::UniverseModel& universe,
+                      const physics::Vector& center)
+{
+    if (universe.empty()) {
+        appendNumber(time / units.time_divisor, '\n');
+        return;
+    }
+    appendNumber(time / units.time_divisor, ' ');
+    for(unsigned i = 0; i < universe.size(); i++) {
+        const physics::Vector p = universe[i].position - center;
+        appendNumber(p[0] / units.length_divisor, ' ');
+        appendNumber(p[1] / units.length_divisor, ' ');
+        appendNumber(p[2] / units.length_divisor,
+                     i + 1 < universe.size() ? ' ' : '\n');
+    }
+}
+
+void
+TextWriter::flush()
+{
+    if (used > 0) {
+        output->write(block.data(), used);
+        written_bytes += used;
+        used = 0;
+    }
+    output->flush();
+    if (!*output)
+        throw Exception("Could not write the output.");
+}
+
+void
+TextWriter::append(const char *text, std::size_t length)
+{
+    while (length > 0) {
+        if (used == block.size())
+            flush();
+        const std::size_t part = std::min(length, block.size() - used);
+        std::memcpy(block.data() + used, text, part);
+        used += part;
+        text += part;
+        length -= part;
+    }
+}
+
+void
+TextWriter::appendNumber(physics::DOUBLE value, char separator)
+{
+    if (block.size() - used < MAX_NUMBER_LENGTH)
+        flush();
+    // "%.15Lg" is what the streams use for std::setprecision(15)
+    const int length = std::snprintf(block.data() + used,
+                                     MAX_NUMBER_LENGTH - 1,
+                                     "%.15Lg", value);
+    Q_ASSERT(length > 0 && std::size_t(length) < MAX_NUMBER_LENGTH - 1);
+    used += length;
+    block[used++] = separator;
+}
+
+}  // namespace output
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ * Space separated text output of the simulation.
+ */
+
+#ifndef __OUTPUT_TEXTWRITER_H__
+#define __OUTPUT_TEXTWRITER_H__
+
+#include <ostream>
+#include <vector>
+#include "output/writer.h"
+
+namespace output
+{
+/**
+ * Writes one line per step - the time followed by the x, y and z coordinates
+ * of every body, with 15 significant digits.
+ *
+ * The numbers are formatted into a large block of memory that is passed to
+ * the stream only when it gets full, so the stream isn't flushed after
+ * every line.
+ */
+class TextWriter : public Writer
+{
+public:
+    /// Default size of the block, in bytes.
+    static const std::size_t BLOCK_SIZE = 1 << 20;
+
+    /// Enough space for one formatted number and the separator.
+    static const std::size_t MAX_NUMBER_LENGTH = 32;
+
+    /**
+     * @param output where the text is written, must outlive the writer
+     * @param units units of the printed values
+     * @param block_size how much text is collected before it is written
+     */
+    explicit TextWriter(std::ostream *output, const Units& units = Units(),
+                        std::size_t block_size = BLOCK_SIZE);
+
+    /// Writes out the rest of the block, errors are ignored.
+    ~TextWriter();
+
+    void writeHeader(const physics::UniverseModel& universe) override;
+    void writeStep(physics::DOUBLE time,
+                   const physics::UniverseModel& universe,
+                   const physics::Vector& center) override;
+    void flush() override;
+
+    /// Number of bytes passed to the stream so far.
+    unsigned long long writtenBytes() const {
+        return written_bytes;
+    }
+
+private:
+    /// Append text, flushing the block when it doesn't fit.
+    void append(const char *text, std::size_t length);
+
+    /// Append the number formatted like `std::setprecision(15)` would,
+    /// followed by the @p separator.
+    void appendNumber(physics::DOUBLE value, char separator);
+
+    std::ostream *output;
+    Units units;
+    std::vector<char> block;
+    /// Number of bytes of the block which are filled.
+    std::size_t used = 0;
+    unsigned long long written_bytes = 0;
+};
+
+}  // namespace output
+
+#endif  // __OUTPUT_TEXTWRITER_H__
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ * Formats of the simulation results and their names.
+ */
+
+#ifndef __OUTPUT_TYPES_H__
+#define __OUTPUT_TYPES_H__
+
+#include <vector>
+#include <QString>
+
+namespace output
+{
+/**
+ * Formats in which nsim-cmd can write the results.
+ * @note The order of the values has to correspond to output::formatName.
+ */
+enum Format {
+    /// One line of space separated numbers per step, see TextWriter.
+    F_TEXT = 0,
+    /// NumPy file with one record per step, see NpyWriter.
+    F_NPY,
+    /// NumPy file with the whole trajectory of each body in one block.
+    F_NPY_BODY_MAJOR
+};
+
+/// Default output format.
+const Format DEFAULT_FORMAT = F_TEXT;
+
+/**
+ * Names of the formats used on the command line.
+ * @note The order of the names has to correspond to the
+ *      `enum` output::Format.
+ */
+const std::vector<QString> formatName {
+    "text",
+    "npy",
+    "npy-body-major"
+};
+}
+
+#endif  // __OUTPUT_TYPES_H__
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ * Interface for the writers of simulation results.
+ */
+
+#ifndef __OUTPUT_WRITER_H__
+#define __OUTPUT_WRITER_H__
+
+#include <string>
+#include "physics/universemodel.h"
+
+namespace output
+{
+/**
+ * Units in which the results are written. The values are divided by the size
+ * of the unit, like parser::convertUnits does, so that they are rounded the
+ * same. The names are stored in the formats which can describe them.
+ */
+struct Units {
+    /// Seconds in the printed unit of time.
+    physics::DOUBLE time_divisor = 1;
+    /// Meters in the printed unit of length.
+    physics::DOUBLE length_divisor = 1;
+    std::string time_name = "s";
+    std::string length_name = "m";
+};
+
+/**
+ * Receives the states of the universe that should be printed, in the order
+ * in which they were computed, and stores them in some format.
+ *
+ * The values are given in the internal units (meters and seconds) and the
+ * writer converts them to the Units it was created with.
+ */
+class Writer
+{
+public:
+    virtual ~Writer() {}
+
+    /// Called once, before the first step is written.
+    virtual void writeHeader(const physics::UniverseModel& universe) = 0;
+
+    /// Write the positions of all the bodies relative to the @p center.
+    virtual void writeStep(physics::DOUBLE time,
+                           const physics::UniverseModel& universe,
+                           const physics::Vector& center) = 0;
+
+    /// Write out everything that is still buffered.
+    /// @throw Exception if the output could not be written.
+    virtual void flush() = 0;
+};
+
+}  // namespace output
+
+#endif  // __OUTPUT_WRITER_H__
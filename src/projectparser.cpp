@@ -22,10 +22,18 @@
  */
 #include "projectparser.h"
 
-#include <QDomDocument>
 #include <QFile>
-#include <QStringList>
+#include <QFileInfo>
+#include <QXmlStreamReader>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QStringRef>
 #include <QDebug>
+#include <cmath>
+#include <limits>
+#include "bodytable.h"
+#include "horizons.h"
+#include "generators/generators.h"
 #include "exceptions.h"
 
 namespace parser
@@ -48,7 +56,7 @@ convertUnits(physics::Vector value, LengthUnit from, LengthUnit to)
     // convert to desired unit
     if(to == LengthUnit::KM)
         return value / 1000;
-    else if(from == LengthUnit::AU)
+    else if(to == LengthUnit::AU)
         return value / ASTRON_UNITS;
     else
         return value;
@@ -65,15 +73,35 @@ convertUnits(physics::Vector value, TimeUnit from, TimeUnit to)
 {
     // convert to seconds first
     if(from == TimeUnit::DAY)
-        value *= 3600;
+        value *= SECONDS_PER_DAY;
 
     // convert to desired unit
     if(to == TimeUnit::DAY)
-        return value / 3600;
+        return value / SECONDS_PER_DAY;
     else
         return value;
 }
 
+QString
+unitName(LengthUnit unit)
+{
+    if(unit == LengthUnit::KM)
+        return "km";
+    else if(unit == LengthUnit::AU)
+        return "AU";
+    else
+        return "m";
+}
+
+QString
+unitName(TimeUnit unit)
+{
+    if(unit == TimeUnit::DAY)
+        return "day";
+    else
+        return "s";
+}
+
 ProjectParser::ProjectParser(QFile *file)
 {
     parse(file);
@@ -91,72 +119,96 @@ ProjectParser::ProjectParser(const QString& fileName)
 void
 ProjectParser::parse(QFile *file)
 {
+    QElapsedTimer timer;
+    timer.start();
     if (!file->open(QFile::ReadOnly | QFile::Text)) {
         QString msg = "Can't read file " + file->fileName()
                       + ": " + file->errorString();
         throw Exception(msg);
     }
-    QDomDocument doc("world");
-
-    QString errorString;
-    int errorLine;
-    int errorColumn;
-    if (!doc.setContent(file, false, &errorString, &errorLine,
-                        &errorColumn)) {
+    project_dir = QFileInfo(*file).absoluteDir();
+    // the file is read in one pass, without building a document in memory
+    QXmlStreamReader xml(file);
+    try {
+        if(!xml.readNextStartElement() || xml.name() != "nsim") {
+            checkError(xml);
+            std::cerr << "root tag is not \"nsim\"\n";
+            throw Exception("bad xml file");
+        }
+        while(xml.readNextStartElement()) {
+            if(xml.name() == "settings") {
+                parseSettings(&xml);
+            } else if(xml.name() == "universe") {
+                parseUniverse(&xml);
+            } else {
+                throw Exception("unknown tag " + xml.name().toString());
+            }
+        }
+        checkError(xml);
+    } catch(...) {
         file->close();
-        QString msg = "Parse error at line ";
-        msg += errorLine + ", ";
-        msg += "column " + errorColumn;
-        msg += ": " + errorString;
-        throw Exception(msg);
+        throw;
     }
     file->close();
 
-    QDomElement root = doc.documentElement();
-    if(root.tagName() != "nsim") {
-        std::cerr << "root tag is not \"nsim\"\n";
-        throw Exception("bad xml file");
-    }
-
-    QDomNode node = root.firstChild();
-    while(!node.isNull()) {
-        QString tag = node.toElement().tagName();
-        if(tag == "settings") {
-            parseSettings(node.toElement());
-        } else if(tag == "universe") {
-            parseUniverse(node.toElement());
-        } else {
-            throw Exception("unknown tag " + tag);
-        }
-        node = node.nextSibling();
-    }
-
     // always use meters, seconds and kilogram in internal representation
     for(auto& body : universe) {
         body.position = convertUnits(body.position,
                                      settings.length_unit, LengthUnit::METER);
         body.velocity = convertUnits(body.velocity,
                                      settings.length_unit, LengthUnit::METER);
+        // the time is in the denominator of the velocity, so it is
+        // converted in the opposite direction
         body.velocity = convertUnits(body.velocity,
-                                     settings.time_unit, TimeUnit::SEC);
+                                     TimeUnit::SEC, settings.time_unit);
         body.radius = convertUnits(body.radius,
                                    settings.length_unit, LengthUnit::METER);
     }
+
+    // generated in the internal units, after the bodies from the file
+    for(auto parameters : generated) {
+        parameters.radius = convertUnits(parameters.radius,
+                                         settings.length_unit,
+                                         LengthUnit::METER);
+        const auto bodies = generators::generate(parameters);
+        universe.insert(universe.end(), bodies.begin(), bodies.end());
+    }
+    generated.clear();
+    importHorizons();
+    if(!universe.empty() && settings.visual_center >= universe.size())
+        throw Exception("Visual center body index is out of range");
+    // every trajectory needs at least one vertex of 3 floats, the default
+    // budget is only clamped by the GUI, as the other tools don't need it
+    if(trail_memory_budget_given && !universe.empty()
+            && settings.trail_memory_budget / universe.size()
+               < 3 * sizeof(float))
+        throw Exception("The trail memory budget is too small for "
+                        + QString::number(universe.size()) + " bodies.");
+
+    qDebug() << "parser:" << universe.size() << "bodies parsed in"
+             << timer.elapsed() << "ms";
 }
 
 void
-ProjectParser::parseUnits(const QDomElement& element)
+ProjectParser::checkError(const QXmlStreamReader& xml)
 {
-    QDomNode node = element.firstChild();
-    QDomElement e;
+    if(xml.hasError()) {
+        throw Exception(QString("Parse error at line %1, column %2: %3")
+                        .arg(xml.lineNumber()).arg(xml.columnNumber())
+                        .arg(xml.errorString()));
+    }
+}
 
-    while(!node.isNull()) {
-        e = node.toElement();
-        QString tag = e.tagName();
+void
+ProjectParser::parseUnits(QXmlStreamReader *xml)
+{
+    while(xml->readNextStartElement()) {
+        const QString tag = xml->name().toString();
         QString text;
         if(tag == "mass") {
+            xml->skipCurrentElement();
         } else if(tag == "length" || tag == "distance") {
-            text = e.text().trimmed();
+            text = xml->readElementText().trimmed();
             qDebug() << "parser: length unit is" << text;
             if(text == "m" || text == "meter") {
                 settings.length_unit = LengthUnit::METER;
@@ -168,7 +220,7 @@ ProjectParser::parseUnits(const QDomElement& element)
                 throw Exception("Unknown length unit " + text);
             }
         } else if(tag == "time") {
-            text = e.text().trimmed();
+            text = xml->readElementText().trimmed();
             qDebug() << "parser: time unit is" << text;
             if(text == "s" || text == "sec" || text == "seconds") {
                 settings.time_unit = TimeUnit::SEC;
@@ -177,89 +229,230 @@ ProjectParser::parseUnits(const QDomElement& element)
             } else {
                 throw Exception("Unknown time unit " + text);
             }
+        } else {
+            xml->skipCurrentElement();
         }
-        node = node.nextSibling();
     }
 }
 
 void
-ProjectParser::parseSettings(const QDomElement& element)
+ProjectParser::parseSettings(QXmlStreamReader *xml)
 {
-    QDomNode node = element.firstChild();
-    QDomElement e;
-
-    while(!node.isNull()) {
-        e = node.toElement();
-        QString tag = e.tagName();
+    while(xml->readNextStartElement()) {
+        const QString tag = xml->name().toString();
         if(tag == "start-date-time") {
+            const QString text = xml->readElementText().trimmed();
+            settings.start_date_time = QDateTime::fromString(text,
+                                                             Qt::ISODate);
+            if(!settings.start_date_time.isValid())
+                throw Exception("Invalid start date and time - " + text);
+            settings.start_date_time.setTimeSpec(Qt::UTC);
         } else if(tag == "units") {
-            parseUnits(e);
+            parseUnits(xml);
         } else if(tag == "body-color") {
             throw Exception("Unimplemented tag 'body-color'");
         } else if(tag == "trajectory-color") {
             throw Exception("Unimplemented tag 'trajectory-color'");
         } else if(tag == "visible-size-multiplier") {
-            settings.visible_size_multiplier = e.text().toInt();
+            settings.visible_size_multiplier = xml->readElementText().toInt();
+        } else if(tag == "trail-memory-budget") {
+            bool ok;
+            const QString text = xml->readElementText();
+            double mib = text.toDouble(&ok);
+            // 4096 MiB wouldn't fit into the unsigned number of bytes
+            if(!ok || mib <= 0 || mib >= 4096)
+                throw Exception("Invalid trail memory budget (in MiB) - "
+                                + text);
+            settings.trail_memory_budget = mib * (1 << 20);
+            trail_memory_budget_given = true;
+        } else if(tag == "resident-trajectories") {
+            QString value = xml->readElementText().trimmed();
+            if(value == "true" || value == "1")
+                settings.resident_trajectories = true;
+            else if(value == "false" || value == "0")
+                settings.resident_trajectories = false;
+            else
+                throw Exception("Invalid value of resident-trajectories - "
+                                + value);
         } else if(tag == "visual-center") {
-            throw Exception("Unimplemented tag 'visual-center'");
+            bool ok;
+            const QString text = xml->readElementText();
+            settings.visual_center = text.trimmed().toUInt(&ok);
+            if(!ok)
+                throw Exception("Invalid visual center body index - "
+                                + text);
         } else {
             throw Exception("Unknown tag in settings - " + tag);
         }
-        node = node.nextSibling();
     }
 }
 
 void
-ProjectParser::parseUniverse(const QDomElement& element)
+ProjectParser::parseUniverse(QXmlStreamReader *xml)
 {
-    QDomNode node = element.firstChild();
-    QDomElement e;
+    // the number of bodies is optional, it only avoids reallocations
+    const QStringRef count = xml->attributes().value("count");
+    if(!count.isEmpty()) {
+        bool ok;
+        const unsigned hint = count.toUInt(&ok);
+        if(!ok)
+            throw Exception("Invalid body count - " + count.toString());
+        universe.reserve(universe.size() + hint);
+    }
 
-    while(!node.isNull()) {
-        e = node.toElement();
-        if(e.tagName() != "body") {
+    while(xml->readNextStartElement()) {
+        if(xml->name() == "body") {
+            universe.emplace_back();
+            parseBody(xml, &universe.back());
+        } else if(xml->name() == "bodies") {
+            parseBodyTable(xml);
+        } else if(xml->name() == "generate") {
+            parseGenerator(xml);
+        } else {
             throw Exception("Unknown tag in <universe>.");
         }
-        physics::Body body;
-        body.name = e.attribute("name", "body");
-        body.visible_size_multiplier = 1;
-        body.acceleration = physics::Vector(0, 0, 0);
-        QDomNode param = e.firstChild();
-        QString tag;
-        physics::Vector *v = 0;
-        while(!param.isNull()) {
-            e = param.toElement();
-            tag = e.tagName();
-            if(tag == "radius") {
-                body.radius = e.text().toDouble();
-            } else if(tag == "visible-size-multiplier") {
-                body.visible_size_multiplier = e.text().toInt();
-            } else if(tag == "mass") {
-                body.mass = e.text().toDouble();
-            } else if(tag == "position") {
-                v = &body.position;
-            } else if(tag == "velocity") {
-                v = &body.velocity;
-            } else {
-                throw Exception("unknown tag");
-            }
+    }
+}
 
-            if(tag == "position" || tag == "velocity") {
-                // @bug weird when the user uses something different for a
-                // separator
-                QStringList list =  e.text().split(",");
-                if(list.size() > 3) {
-                    throw Exception("vector is max 3D");
-                }
-                for(int i = 0; i < list.size(); ++i) {
-                    (*v)[i] = list[i].toDouble();
-                }
-            }
-            param = param.nextSibling();
+void
+ProjectParser::parseGenerator(QXmlStreamReader *xml)
+{
+    // the attributes refer to the data of the reader, they have to be used
+    // before reading further
+    const QXmlStreamAttributes attributes = xml->attributes();
+    generators::Parameters parameters;
+
+    const QString model = attributes.value("model").toString();
+    bool valid = false;
+    for(unsigned i = 0; i < generators::modelName.size(); ++i) {
+        if(model == generators::modelName[i]) {
+            valid = true;
+            parameters.model = (generators::Model) i;
+            break;
+        }
+    }
+    if(valid == false)
+        throw Exception("Unknown model in <generate> - " + model);
+
+    bool ok = true;
+    if(attributes.hasAttribute("count"))
+        parameters.count = attributes.value("count").toUInt(&ok);
+    if(ok && attributes.hasAttribute("seed"))
+        parameters.seed = attributes.value("seed").toULongLong(&ok);
+    if(ok && attributes.hasAttribute("mass"))
+        parameters.mass = attributes.value("mass").toDouble(&ok);
+    if(ok && attributes.hasAttribute("radius"))
+        parameters.radius = attributes.value("radius").toDouble(&ok);
+    if(!ok)
+        throw Exception("Invalid number in <generate>.");
+    xml->skipCurrentElement();
+    // the radius is converted when the units are known
+    generated.push_back(parameters);
+}
+
+void
+ProjectParser::parseBodyTable(QXmlStreamReader *xml)
+{
+    const QString file = xml->attributes().value("file").toString();
+    const QString format = xml->attributes().value("format").toString();
+    xml->skipCurrentElement();
+    if(file.isEmpty())
+        throw Exception("Missing file name in <bodies>.");
+
+    BodyTableFormat table_format;
+    if(format == "csv" || (format.isEmpty() && file.endsWith(".csv"))) {
+        table_format = BodyTableFormat::CSV;
+    } else if(format == "binary" || format.isEmpty()) {
+        table_format = BodyTableFormat::BINARY;
+    } else {
+        throw Exception("Unknown format of the body table - " + format);
+    }
+    // relative paths start in the directory of the project file
+    loadBodyTable(project_dir.absoluteFilePath(file), table_format,
+                  &universe);
+}
+
+void
+ProjectParser::parseBody(QXmlStreamReader *xml, physics::Body *body)
+{
+    const QStringRef name = xml->attributes().value("name");
+    body->name = name.isNull() ? QString("body") : name.toString();
+    body->visible_size_multiplier = 1;
+    body->acceleration = physics::Vector(0, 0, 0);
+
+    while(xml->readNextStartElement()) {
+        const QStringRef tag = xml->name();
+        if(tag == "radius") {
+            body->radius = xml->readElementText().toDouble();
+        } else if(tag == "visible-size-multiplier") {
+            body->visible_size_multiplier = xml->readElementText().toInt();
+        } else if(tag == "mass") {
+            body->mass = xml->readElementText().toDouble();
+        } else if(tag == "position") {
+            parseVector(xml->readElementText(), &body->position);
+        } else if(tag == "velocity") {
+            parseVector(xml->readElementText(), &body->velocity);
+        } else if(tag == "horizons") {
+            parseHorizons(xml, body - &universe.front());
+        } else {
+            throw Exception("unknown tag");
+        }
+    }
+}
+
+void
+ProjectParser::parseHorizons(QXmlStreamReader *xml, std::size_t body)
+{
+    const QXmlStreamAttributes attributes = xml->attributes();
+    HorizonsSource horizons;
+    horizons.body = body;
+    horizons.file = attributes.value("file").toString();
+    horizons.julian_date = std::numeric_limits<physics::DOUBLE>::quiet_NaN();
+    if(attributes.hasAttribute("jd")) {
+        bool ok;
+        horizons.julian_date = attributes.value("jd").toDouble(&ok);
+        if(!ok)
+            throw Exception("Invalid Julian date in <horizons> - "
+                            + attributes.value("jd").toString());
+    }
+    xml->skipCurrentElement();
+    if(horizons.file.isEmpty())
+        throw Exception("Missing file name in <horizons>.");
+    // relative paths start in the directory of the project file
+    horizons.file = project_dir.absoluteFilePath(horizons.file);
+    horizons_sources.push_back(horizons);
+}
+
+void
+ProjectParser::importHorizons()
+{
+    // the tables are in kilometers, so this is done after the conversion of
+    // units, to not depend on the units of the project
+    for(auto& horizons : horizons_sources) {
+        if(std::isnan(horizons.julian_date)) {
+            if(!settings.start_date_time.isValid())
+                throw Exception("The <horizons> tag needs a start date and"
+                                " time or the jd attribute.");
+            horizons.julian_date = julianDate(settings.start_date_time);
         }
+        const StateVector state = horizonsState(
+            readHorizonsTable(horizons.file), horizons.julian_date);
+        physics::Body& body = universe[horizons.body];
+        body.position = state.position;
+        body.velocity = state.velocity;
+    }
+}
 
-        universe.push_back(body);
-        node = node.nextSibling();
+void
+ProjectParser::parseVector(const QString& text, physics::Vector *v)
+{
+    // @bug weird when the user uses something different for a separator
+    const QVector<QStringRef> list = text.splitRef(",");
+    if(list.size() > 3) {
+        throw Exception("vector is max 3D");
+    }
+    for(int i = 0; i < list.size(); ++i) {
+        (*v)[i] = list[i].toDouble();
     }
 }
 }  // namespace
@@ -26,10 +26,12 @@
 
 #include <QDateTime>
 #include <QColor>
+#include <QDir>
 #include "physics/universemodel.h"
+#include "generators/generators.h"
 
 class QDateTime;
-class QDomElement;
+class QXmlStreamReader;
 class QFile;
 class QString;
 
@@ -46,6 +48,9 @@ enum class TimeUnit { SEC, DAY };
 // AU in meters
 const physics::DOUBLE ASTRON_UNITS = 1.495978707e11;
 
+// day in seconds
+const physics::DOUBLE SECONDS_PER_DAY = 86400;
+
 physics::DOUBLE convertUnits(physics::DOUBLE value,
                              LengthUnit from, LengthUnit to);
 
@@ -58,6 +63,12 @@ physics::DOUBLE convertUnits(physics::DOUBLE value,
 physics::Vector convertUnits(physics::Vector value,
                              TimeUnit from, TimeUnit to);
 
+/// Symbol of the unit, as it is written in the project file.
+QString unitName(LengthUnit unit);
+
+/// Symbol of the unit, as it is written in the project file.
+QString unitName(TimeUnit unit);
+
 /**
  * Parameters given to the simulation and animation.
  * @see Simulation
@@ -79,7 +90,9 @@ struct ProjectSettings {
     TimeUnit time_unit = TimeUnit::SEC;
 
     /// Index of a body in UniverseModel to which the animation will be
-    /// centered. Default is 0 (the first body in the project file).
+    /// centered. Default is 0 (the first body in the project file). Positions
+    /// in the SimulationHistory are saved relative to it, so that the bodies
+    /// around it can be drawn without losing precision.
     unsigned visual_center = 0;
 
     /// Default color of all the celestial bodies.
@@ -92,14 +105,61 @@ struct ProjectSettings {
     /// of celestial bodies will be normal, if equal to 2, they will be
     /// shown 2x larger. Used to make very small bodies visible.
     int visible_size_multiplier = 1;
+
+    /// How much GPU memory (in bytes) can the trajectories of all the bodies
+    /// take together. The longer the trajectories, the more memory they need.
+    /// Given in MiB in the project file, less than 4096 and at least one
+    /// vertex for every body. The default budget is exceeded if there are
+    /// too many bodies for it.
+    unsigned trail_memory_budget = 1 << 20;  // 1 MiB
+
+    /// Keep the whole simulation history in GPU memory, so that the
+    /// trajectories can be drawn from any point in time without copying.
+    /// The memory budget then only determines the length of the trails.
+    /// Once the history outgrows TrajectoryBuffer::DEFAULT_MEMORY_BUDGET, the
+    /// trails are kept in the ring buffers again.
+    bool resident_trajectories = false;
 };
 
 /**
  * Parser of the input XML file with the model specifications.
+ *
+ * The file is read with a stream reader in one pass, so even universes with
+ * millions of bodies take little more memory than the UniverseModel itself.
+ * The `<universe>` tag can have a `count` attribute with the number of the
+ * bodies, which is used to allocate the memory at once.
+ *
+ * Besides `<body>` tags, the universe can contain tags like
+ * `<bodies file="stars.csv" format="csv"/>` which load many bodies from a
+ * table, see loadBodyTable. The format is `csv` or `binary`, by default
+ * guessed from the file name.
+ *
+ * Synthetic universes are added by tags like
+ * `<generate model="plummer" count="10000" mass="2e30" radius="1e9"
+ * seed="1"/>`, see generators::generate. The mass is in kilograms and the
+ * radius in the length unit of the project. The generated bodies are placed
+ * after all the bodies given in the file.
+ *
+ * The position and velocity of a body can be imported from a table of
+ * vectors exported from JPL HORIZONS by `<horizons file="data/earth.txt"/>`
+ * inside the `<body>` tag, see readHorizonsTable. The state is taken at the
+ * `<start-date-time>` of the settings, or at the Julian date given by the
+ * `jd` attribute.
  */
 class ProjectParser
 {
 public:
+    /// Body whose initial state was read from a HORIZONS table.
+    struct HorizonsSource {
+        /// Index of the body in the UniverseModel.
+        std::size_t body;
+        /// Absolute path of the table.
+        QString file;
+        /// Julian date of the initial state, NaN while parsing if the start
+        /// time should be used.
+        physics::DOUBLE julian_date;
+    };
+
     explicit ProjectParser(QFile *file);
     explicit ProjectParser(const QString& fileName);
 
@@ -109,15 +169,38 @@ public:
     ProjectSettings getSettings() const {
         return settings;
     }
+    /// Bodies whose state was imported by the `<horizons>` tag, the tables
+    /// can be used as a reference to compare the simulation with.
+    const std::vector<HorizonsSource>& getHorizonsSources() const {
+        return horizons_sources;
+    }
 
 private:
     physics::UniverseModel universe;
     ProjectSettings settings;
+    /// Directory of the parsed file, used for the paths inside it.
+    QDir project_dir;
+    /// Universes generated when the whole file is parsed.
+    std::vector<generators::Parameters> generated;
+    /// States imported from HORIZONS when the whole file is parsed.
+    std::vector<HorizonsSource> horizons_sources;
+    /// Whether the file sets ProjectSettings::trail_memory_budget.
+    bool trail_memory_budget_given = false;
 
     void parse(QFile *file);
-    void parseUniverse(const QDomElement& element);
-    void parseSettings(const QDomElement& element);
-    void parseUnits(const QDomElement& element);
+    void parseUniverse(QXmlStreamReader *xml);
+    void parseBody(QXmlStreamReader *xml, physics::Body *body);
+    void parseBodyTable(QXmlStreamReader *xml);
+    void parseGenerator(QXmlStreamReader *xml);
+    void parseHorizons(QXmlStreamReader *xml, std::size_t body);
+    void importHorizons();
+    void parseSettings(QXmlStreamReader *xml);
+    void parseUnits(QXmlStreamReader *xml);
+
+    /// @throw Exception with the position of the error in the file, if
+    ///     there was any
+    static void checkError(const QXmlStreamReader& xml);
+    static void parseVector(const QString& text, physics::Vector *v);
 };
 }  // namespace
 
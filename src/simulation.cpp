@@ -66,23 +66,48 @@ Simulation::changeComputationIntensity(AnimationState state)
     }
     // ignore other
 }
+
+void
+Simulation::prefetch(physics::DOUBLE drawn_time, double playback_rate)
+{
+    if(!timer->isActive()) return;
+    const bool ahead = time.time() - drawn_time > PREFETCH_TIME * playback_rate;
+    const int interval = ahead ? PREFETCHED_TICK_INTERVAL : 0;
+    if(timer->interval() != interval)
+        timer->setInterval(interval);
+}
 void
 Simulation::compute()
 {
     assert(universe.size() > 0);
     while(true) {
-        algorithm->computeStep(&universe, time.timeStep());
-        time.updateTime();
-
-        counter++;
-        if(counter % save_state_step == 0) {
-            simulation_history->save(universe, time);
-        }
+        step();
         if(counter % steps_in_tick == 0)
             return;
     }
 }
 
+void
+Simulation::computeUntil(unsigned history_size)
+{
+    assert(universe.size() > 0);
+    while(simulation_history->historySize() < history_size)
+        step();
+}
+
+void
+Simulation::step()
+{
+    algorithm->computeStep(&universe, time.timeStep());
+    time.updateTime();
+
+    counter++;
+    computed_steps++;
+    if(counter % save_state_step == 0) {
+        simulation_history->save(universe, time, algorithm.get());
+    }
+}
+
 void
 Simulation::loadUniverse(physics::UniverseModel universe,
                          parser::ProjectSettings settings)
@@ -91,11 +116,13 @@ Simulation::loadUniverse(physics::UniverseModel universe,
     this->settings = settings;
     time.setTime(0);
     simulation_history->clear();
+    // keep the precision around the body the animation is centered to
+    simulation_history->setOrigin(settings.visual_center);
     algorithm->reset();
     counter = 0;
 
     // save initial positions into buffer
-    simulation_history->save(universe, time);
+    simulation_history->save(universe, time, algorithm.get(), true);
     changeComputationIntensity(PAUSED);
 }
 
@@ -113,23 +140,59 @@ Simulation::setAlgorithm(algorithms::Type type,
                          physics::DOUBLE timeStep,
                          unsigned history_index)
 {
-    bool load_history = false;
     assert(timeStep > 0);
+    const bool type_changed = type != algorithm->getType();
+    const bool step_changed = !physics::equal(timeStep, time.timeStep());
+    if(!type_changed && !step_changed)
+        return;
+
+    const bool load_history = simulation_history->historySize() > 0;
+    if(load_history)
+        resume(history_index);
 
-    if(type != algorithm->getType()) {
-        algorithm = std::move(algorithms::factory(type));
-        load_history = true;
+    // the history of multi-step algorithms is only valid for one time step,
+    // so start with a new algorithm even if only the step has changed
+    algorithm = algorithms::factory(type);
+    if(type_changed)
         qDebug() << "algorithm changed to " << algorithms::typeName[type];
+    time.setTimeStep(timeStep);
+    save_state_step = SAVE_STATE_INTERVAL / time.timeStep();
+    if(save_state_step == 0) save_state_step = 1;
+
+    if(load_history) {
+        // overwrite the history from history_index, which becomes the
+        // keyframe of the new algorithm
+        simulation_history->clear(history_index);
+        simulation_history->save(universe, time, algorithm.get(), true);
+        counter = 0;
     }
-    if(!physics::equal(timeStep, time.timeStep())) {
-        time.setTimeStep(timeStep);
-        save_state_step = SAVE_STATE_INTERVAL / time.timeStep();
-        if(save_state_step == 0) save_state_step = 1;
-        load_history = true;
-    }
-    if(load_history && simulation_history->historySize() > 0) {
+}
+
+void
+Simulation::resume(unsigned history_index)
+{
+    const Keyframe *keyframe = simulation_history->keyframe(history_index);
+    if(keyframe == nullptr) {
+        // only the reduced precision is available
         simulation_history->load(history_index, &universe, &time);
-        simulation_history->clear(history_index);
+        return;
+    }
+    assert(keyframe->positions.size() == universe.size());
+    for(unsigned i = 0; i < universe.size(); i++) {
+        universe[i].position = keyframe->positions[i];
+        universe[i].velocity = keyframe->velocities[i];
+    }
+
+    // repeat the computation between the keyframe and history_index, using
+    // the same algorithm and step, so that the result is identical
+    auto replay = algorithms::factory(keyframe->algorithm);
+    replay->setHistory(keyframe->algorithm_history);
+    time.setTimeStep(keyframe->time_step);
+    time.setTime(simulation_history->savedTime(keyframe->index));
+    const physics::DOUBLE target = simulation_history->savedTime(history_index);
+    while(time.time() < target - time.timeStep()/2) {
+        replay->computeStep(&universe, time.timeStep());
+        time.updateTime();
     }
-    time.timeStep();
+    time.setTime(target);
 }
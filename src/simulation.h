@@ -45,6 +45,14 @@ const unsigned SAVE_STATE_INTERVAL = 60*60*2;  // seconds
 /// How many algorithm steps will be computed with one timer tick.
 const unsigned DEFAULT_COMPUTE_STEPS_IN_TICK = 200;
 
+/// How many seconds of real time should the simulation be ahead of the
+/// playing animation.
+const double PREFETCH_TIME = 2;
+
+/// Timer interval (in milliseconds) while the simulation is far enough ahead
+/// of the animation.
+const int PREFETCHED_TICK_INTERVAL = 50;
+
 /**
  * The simulation runner of the whole application. Calls itself using a
  * timer.
@@ -62,14 +70,31 @@ public:
     void loadUniverse(physics::UniverseModel universe,
                       parser::ProjectSettings settings);
 
+    /// Compute without waiting for the timer until the history contains at
+    /// least `history_size` states.
+    void computeUntil(unsigned history_size);
+
+    /// How many steps of the algorithm were computed since the start.
+    unsigned long computedSteps() const {
+        return computed_steps;
+    }
+
 public slots:
     /// Start or stop the simulation according to action.
     void startOrStop(bool action);
 
     void changeComputationIntensity(AnimationState state);
 
+    /** Compute at full speed only while the simulation is less than
+     * PREFETCH_TIME ahead of the playing animation.
+     * @param drawn_time: simulation time drawn by the animation, in seconds
+     * @param playback_rate: simulation seconds played per second of real time
+     */
+    void prefetch(physics::DOUBLE drawn_time, double playback_rate);
+
     /// If the type or step of algorithm is different, change them, load
-    /// simulation state from bufferPosition clean the simulation history.
+    /// simulation state from history_index and clean the simulation history
+    /// after it.
     void setAlgorithm(algorithms::Type type,
                       physics::DOUBLE timeStep,
                       unsigned history_index);
@@ -81,6 +106,13 @@ private slots:
     void compute();
 
 private:
+    /// Run one step of the algorithm and save the state if it's time to.
+    void step();
+
+    /// Restore the exact state of the universe at history_index, by
+    /// recomputing it from the previous Keyframe in the history.
+    void resume(unsigned history_index);
+
     unsigned steps_in_tick;
     std::shared_ptr<SimulationHistory> simulation_history;
     physics::SimulationTime time;
@@ -96,6 +128,9 @@ private:
 
     /// Counter of simulation algorithm steps.
     unsigned counter;
+
+    /// Like Simulation::counter, but never reset.
+    unsigned long computed_steps = 0;
 };
 
 #endif  // __SIMULATION_H__
@@ -30,7 +30,9 @@
 
 void
 SimulationHistory::save(const physics::UniverseModel& universe,
-                        const physics::SimulationTime& time)
+                        const physics::SimulationTime& time,
+                        algorithms::Base *algorithm,
+                        bool force_keyframe)
 {
     if (universe.size() == 0)
         throw Exception("The universe model is empty");
@@ -42,26 +44,79 @@ SimulationHistory::save(const physics::UniverseModel& universe,
         msg += ")";
         throw Exception(msg);
     }
+    if (origin_index >= static_cast<int>(universe.size()))
+        throw Exception("The origin body index is out of range");
     // first save
     if (N == 0) {
         N = universe.size();
         positions.resize(N);
         velocities.resize(N);
+        decimated.assign(HISTORY_LEVELS - 1,
+                         std::vector<std::vector<GLfloat> >(N));
     }
+    const unsigned index = times.size();
 
+    physics::Vector origin_position, origin_velocity;
+    if (hasOrigin()) {
+        origin_position = universe[origin_index].position;
+        origin_velocity = universe[origin_index].velocity;
+        origin_positions.push_back(origin_position.x());
+        origin_positions.push_back(origin_position.y());
+        origin_positions.push_back(origin_position.z());
+        origin_velocities.push_back(origin_velocity.x());
+        origin_velocities.push_back(origin_velocity.y());
+        origin_velocities.push_back(origin_velocity.z());
+    }
     for(unsigned i = 0; i < N; i++) {
-        positions[i].push_back(universe[i].position.x());
-        positions[i].push_back(universe[i].position.y());
-        positions[i].push_back(universe[i].position.z());
-        velocities[i].push_back(universe[i].velocity.x());
-        velocities[i].push_back(universe[i].velocity.y());
-        velocities[i].push_back(universe[i].velocity.z());
+        // subtract in full precision, before converting to float
+        const physics::Vector p = universe[i].position - origin_position;
+        const physics::Vector v = universe[i].velocity - origin_velocity;
+        positions[i].push_back(p.x());
+        positions[i].push_back(p.y());
+        positions[i].push_back(p.z());
+        velocities[i].push_back(v.x());
+        velocities[i].push_back(v.y());
+        velocities[i].push_back(v.z());
+    }
+    // a state that belongs to level k also belongs to all levels below it
+    for(unsigned level = 1; level < HISTORY_LEVELS; level++) {
+        if(index % levelStride(level) != 0) break;
+        for(unsigned i = 0; i < N; i++) {
+            const GLfloat *p = &positions[i][index * 3];
+            decimated[level - 1][i].insert(decimated[level - 1][i].end(),
+                                           p, p + 3);
+        }
+    }
+    if (algorithm != nullptr
+            && (force_keyframe || index % KEYFRAME_INTERVAL == 0)) {
+        Keyframe keyframe;
+        keyframe.index = index;
+        for (const auto& body: universe) {
+            keyframe.positions.push_back(body.position);
+            keyframe.velocities.push_back(body.velocity);
+        }
+        keyframe.time_step = time.timeStep();
+        keyframe.algorithm = algorithm->getType();
+        keyframe.algorithm_history = algorithm->getHistory();
+        keyframes.push_back(keyframe);
     }
     times.push_back(time.time());
     Q_ASSERT(positions[0].size() == times.size() * 3);
     Q_ASSERT(velocities[0].size() == times.size() * 3);
 }
 
+const Keyframe*
+SimulationHistory::keyframe(const unsigned index) const
+{
+    // the first keyframe after index
+    const auto next = std::upper_bound(
+        keyframes.begin(), keyframes.end(), index,
+        [](unsigned i, const Keyframe& k) { return i < k.index; });
+    if (next == keyframes.begin())
+        return nullptr;
+    return &(*(next - 1));
+}
+
 void
 SimulationHistory::load(const unsigned index,
                         physics::UniverseModel *universe,
@@ -74,6 +129,13 @@ SimulationHistory::load(const unsigned index,
     if (times.size() <= index)
         throw Exception("Simulation history is smaller than requested index");
 
+    physics::Vector origin_velocity;
+    if (hasOrigin()) {
+        origin_velocity.set(origin_velocities[index * 3],
+                            origin_velocities[index * 3 + 1],
+                            origin_velocities[index * 3 + 2]);
+    }
+    const physics::Vector origin_position = originPosition(index);
     for(unsigned i = 0; i < N; i++) {
         universe->at(i).position.set(positions[i][index * 3],
                                      positions[i][index * 3 + 1],
@@ -81,17 +143,52 @@ SimulationHistory::load(const unsigned index,
         universe->at(i).velocity.set(velocities[i][index * 3],
                                      velocities[i][index * 3 + 1],
                                      velocities[i][index * 3 + 2]);
+        universe->at(i).position += origin_position;
+        universe->at(i).velocity += origin_velocity;
     }
     time->setTime(times[index]);
 }
 
+void
+SimulationHistory::setOrigin(const unsigned body_index)
+{
+    if (!empty())
+        throw Exception("The origin can't be changed in a non-empty history");
+    origin_index = body_index;
+}
+
+void
+SimulationHistory::unsetOrigin()
+{
+    if (!empty())
+        throw Exception("The origin can't be changed in a non-empty history");
+    origin_index = -1;
+}
+
+physics::Vector
+SimulationHistory::originPosition(const unsigned index) const
+{
+    if (index >= times.size())
+        throw Exception("Requested index out of range in history");
+    if (!hasOrigin())
+        return physics::Vector();
+    return physics::Vector(origin_positions[index * 3],
+                           origin_positions[index * 3 + 1],
+                           origin_positions[index * 3 + 2]);
+}
+
 void
 SimulationHistory::clear()
 {
     positions.clear();
     velocities.clear();
+    decimated.clear();
+    keyframes.clear();
+    origin_positions.clear();
+    origin_velocities.clear();
     times.clear();
     N = 0;
+    revision_count++;
 }
 
 void
@@ -103,6 +200,7 @@ SimulationHistory::clear(unsigned from_index)
         clear();
         return;
     }
+    revision_count++;
     for (auto& p: positions) {
         Q_ASSERT(p.size() > from_index * 3);
         p.erase(p.begin() + (from_index * 3), p.end());
@@ -111,6 +209,21 @@ SimulationHistory::clear(unsigned from_index)
         Q_ASSERT(v.size() > from_index * 3);
         v.erase(v.begin() + (from_index * 3), v.end());
     }
+    for(unsigned level = 1; level < HISTORY_LEVELS; level++) {
+        // number of states with index < from_index which belong to the level
+        const unsigned stride = levelStride(level);
+        const unsigned kept = (from_index + stride - 1) / stride;
+        for (auto& p: decimated[level - 1]) {
+            if (p.size() > kept * 3)
+                p.erase(p.begin() + (kept * 3), p.end());
+        }
+    }
+    while (!keyframes.empty() && keyframes.back().index >= from_index)
+        keyframes.pop_back();
+    if (hasOrigin()) {
+        origin_positions.resize(from_index * 3);
+        origin_velocities.resize(from_index * 3);
+    }
     times.erase(times.begin() + from_index, times.end());
     Q_ASSERT(positions[0].size() == times.size() * 3);
     Q_ASSERT(velocities[0].size() == times.size() * 3);
@@ -124,15 +237,126 @@ SimulationHistory::bodyPosition(const unsigned body_index,
         throw Exception("Requested body index out of range in history");
     if (index >= times.size())
         throw Exception("Requested index out of range in history");
-    return QVector3D(positions[body_index][index * 3],
-                     positions[body_index][index * 3 + 1],
-                     positions[body_index][index * 3 + 2]);
+    return bodyPositions(body_index).vertex(index);
 }
 
-const std::vector<GLfloat>&
+physics::DOUBLE
+SimulationHistory::savedTime(const unsigned index) const
+{
+    if (index >= times.size())
+        throw Exception("Requested index out of range in history");
+    return times[index];
+}
+
+HistoryPosition
+SimulationHistory::seek(const physics::DOUBLE time) const
+{
+    if (times.empty())
+        throw Exception("No data were saved yet into the history");
+    HistoryPosition result;
+    if (time <= times.front())
+        return result;
+    if (time >= times.back()) {
+        result.index = result.next = times.size() - 1;
+        return result;
+    }
+
+    // the saved states index and index+1 surround the requested time
+    const auto next = std::upper_bound(times.begin(), times.end(), time);
+    result.index = (next - times.begin()) - 1;
+    result.next = result.index + 1;
+    const physics::DOUBLE h = times[result.next] - times[result.index];
+    if (h > 0)
+        result.factor = (time - times[result.index]) / h;
+    return result;
+}
+
+std::vector<PositionSpan>
+SimulationHistory::window(const physics::DOUBLE from,
+                          const physics::DOUBLE until,
+                          unsigned *first_index) const
+{
+    const auto first = std::lower_bound(times.begin(), times.end(), from);
+    const auto last = std::upper_bound(first, times.end(), until);
+    const unsigned index = first - times.begin();
+    const unsigned count = last - first;
+    if (first_index != nullptr)
+        *first_index = index;
+
+    std::vector<PositionSpan> result;
+    result.reserve(N);
+    for (unsigned i = 0; i < N; i++)
+        result.push_back(bodyPositions(i).subspan(index, count));
+    return result;
+}
+
+QVector3D
+SimulationHistory::interpolatedBodyPosition(const unsigned body_index,
+                                            const physics::DOUBLE time) const
+{
+    return interpolatedBodyPosition(body_index, seek(time));
+}
+
+QVector3D
+SimulationHistory::interpolatedBodyPosition(
+    const unsigned body_index,
+    const HistoryPosition& position) const
+{
+    if (body_index >= N)
+        throw Exception("Requested body index out of range in history");
+    if (position.next >= times.size() || position.index > position.next)
+        throw Exception("Requested index out of range in history");
+    const unsigned i = position.index;
+    if (position.next == i || position.factor <= 0)
+        return bodyPosition(body_index, i);
+    const physics::DOUBLE h = times[position.next] - times[i];
+    const physics::DOUBLE s = position.factor;
+
+    // cubic Hermite basis functions
+    const physics::DOUBLE h00 = 2*s*s*s - 3*s*s + 1;
+    const physics::DOUBLE h10 = s*s*s - 2*s*s + s;
+    const physics::DOUBLE h01 = -2*s*s*s + 3*s*s;
+    const physics::DOUBLE h11 = s*s*s - s*s;
+
+    const auto& p = positions[body_index];
+    const auto& v = velocities[body_index];
+    physics::DOUBLE result[3];
+    for (unsigned j = 0; j < 3; j++) {
+        result[j] = h00 * p[i * 3 + j] + h10 * h * v[i * 3 + j]
+                    + h01 * p[position.next * 3 + j]
+                    + h11 * h * v[position.next * 3 + j];
+    }
+    return QVector3D(result[0], result[1], result[2]);
+}
+
+PositionSpan
 SimulationHistory::bodyPositions(const unsigned body_index) const
 {
     if (body_index >= N)
         throw Exception("Index out of range");
-    return positions[body_index];
+    return PositionSpan(positions[body_index].data(),
+                        positions[body_index].size());
+}
+
+PositionSpan
+SimulationHistory::bodyPositions(const unsigned body_index,
+                                 const unsigned level) const
+{
+    if (level == 0)
+        return bodyPositions(body_index);
+    if (body_index >= N)
+        throw Exception("Index out of range");
+    if (level >= HISTORY_LEVELS)
+        throw Exception("Requested level out of range in history");
+    const auto& p = decimated[level - 1][body_index];
+    return PositionSpan(p.data(), p.size());
+}
+
+unsigned
+SimulationHistory::levelForStride(const unsigned stride)
+{
+    unsigned level = 0;
+    while (level + 1 < HISTORY_LEVELS && levelStride(level + 1) <= stride)
+        level++;
+    return level;
 }
@@ -30,7 +30,115 @@
 #include "physics/universemodel.h"
 #include "physics/simulationtime.h"
 #include "physics/precision.h"
+#include "algorithms/base.h"
+#include "algorithms/types.h"
 
+/** Number of resolution levels kept in the SimulationHistory. Level 0 contains
+ * every saved state, level k only every 2^k-th one, so the last level has a
+ * stride of 2^(HISTORY_LEVELS-1) saved states.
+ */
+const unsigned HISTORY_LEVELS = 14;
+
+/** Every KEYFRAME_INTERVAL-th saved state is also stored as a Keyframe.
+ */
+const unsigned KEYFRAME_INTERVAL = 16;
+
+/** Full precision state of the simulation at one saved state of the
+ * SimulationHistory. It contains everything needed to resume the computation
+ * exactly, including the state of multi-step algorithms, so that they don't
+ * have to start again with Runge-Kutta steps.
+ */
+struct Keyframe {
+    /// Index of the saved state in the SimulationHistory.
+    unsigned index = 0;
+    std::vector<physics::Vector> positions;
+    std::vector<physics::Vector> velocities;
+    /// Time step used to compute the states following this keyframe.
+    physics::DOUBLE time_step = 0;
+    /// Algorithm used to compute the states following this keyframe.
+    algorithms::Type algorithm = algorithms::DEFAULT_TYPE;
+    /// @see algorithms::Base::getHistory
+    algorithms::History algorithm_history;
+};
+
+
+/** Read-only view of positions saved in the SimulationHistory, which doesn't
+ * copy them. There are 3 floating point numbers for each position (vertex),
+ * stored continuously so that they can be given directly to OpenGL.
+ *
+ * @warning The view is only valid until the history is modified, i.e. until
+ * the next call of SimulationHistory::save or SimulationHistory::clear.
+ */
+class PositionSpan
+{
+public:
+    PositionSpan() {}
+    PositionSpan(const GLfloat *data, unsigned size)
+        : ptr(data), length(size) {}
+
+    /// Pointer to the first number, nullptr if empty.
+    const GLfloat* data() const {
+        return ptr;
+    }
+
+    /// Number of floating point numbers, i.e. 3x the number of vertices.
+    unsigned size() const {
+        return length;
+    }
+
+    unsigned vertexCount() const {
+        return length / 3;
+    }
+
+    bool empty() const {
+        return length == 0;
+    }
+
+    const GLfloat& operator[](const unsigned i) const {
+        return ptr[i];
+    }
+
+    const GLfloat* begin() const {
+        return ptr;
+    }
+
+    const GLfloat* end() const {
+        return ptr + length;
+    }
+
+    /// Get the position at vertex index.
+    QVector3D vertex(const unsigned index) const {
+        Q_ASSERT(index < vertexCount());
+        return QVector3D(ptr[index * 3], ptr[index * 3 + 1], ptr[index * 3 + 2]);
+    }
+
+    /** View only `count` vertices starting from the vertex `first`. The range
+     * is cut to fit into this view.
+     */
+    PositionSpan subspan(unsigned first, unsigned count) const {
+        if (first > vertexCount()) first = vertexCount();
+        if (count > vertexCount() - first) count = vertexCount() - first;
+        return PositionSpan(ptr + first * 3, count * 3);
+    }
+
+private:
+    const GLfloat *ptr = nullptr;
+    unsigned length = 0;
+};
+
+/** Position in the SimulationHistory at some simulation time.
+ * @see SimulationHistory::seek
+ */
+struct HistoryPosition {
+    /// Index of the last saved state at or before the time.
+    unsigned index = 0;
+    /// Index of the saved state after SimulationHistory::index, or the same
+    /// index if it is the last one.
+    unsigned next = 0;
+    /// Where the time lies between the two states, from 0 (at index) to 1
+    /// (at next).
+    physics::DOUBLE factor = 0;
+};
 
 /** Save history of simulation results, so that they can be animated.
  *
@@ -38,6 +146,23 @@
  * algorithm and overwrite the history (from that position) with the new
  * values. Therefore, some values that aren't necessary for the animation
  * itself have to be stored, e.g. velocity.
+ *
+ * Besides the full resolution positions, decimated copies (levels) are kept
+ * and updated on each save, similar to mipmaps. When the animation runs very
+ * fast, it can read a coarser level and upload only a few positions per frame
+ * instead of all of them.
+ *
+ * The saved positions and velocities only have the precision of `GLfloat`, so
+ * if the algorithm is given when saving, every KEYFRAME_INTERVAL-th state is
+ * also saved as a full precision Keyframe. The computation can be resumed
+ * exactly from any saved state by recomputing it from the previous keyframe.
+ *
+ * At the scale of a solar system, the float precision isn't enough to tell
+ * apart a planet and its moon. If an origin body is set, positions and
+ * velocities are saved relative to it instead - the difference is computed in
+ * full precision and only then converted to float. The absolute position and
+ * velocity of the origin body itself is kept in double, so that the absolute
+ * values can be restored by SimulationHistory::load.
  */
 class SimulationHistory
 {
@@ -46,9 +171,16 @@ public:
 
     /** Save the positions and velocities of all bodies in the universe. The
      * time has to be equal or greater than the previously saved time.
+     *
+     * @param algorithm: the algorithm that computed the universe state. If
+     *      given, a Keyframe is saved every KEYFRAME_INTERVAL-th time.
+     * @param force_keyframe: save a Keyframe now, regardless of the interval
+     *      (only if the algorithm is given)
      */
     void save(const physics::UniverseModel& universe,
-              const physics::SimulationTime& time);
+              const physics::SimulationTime& time,
+              algorithms::Base *algorithm = nullptr,
+              bool force_keyframe = false);
 
     /** Restore the positions and velocities of all bodies from the history at
      * the specified index into the physics::UniverseModel.
@@ -57,6 +189,30 @@ public:
               physics::UniverseModel *universe,
               physics::SimulationTime *time) const;
 
+    /** Get the last keyframe saved at or before the state at index, or
+     * nullptr if there is none.
+     */
+    const Keyframe* keyframe(const unsigned index) const;
+
+    /** Save all the following positions and velocities relative to the body
+     * at body_index, which will then always be at [0, 0, 0]. Can be set only
+     * while the history is empty and stays set after clearing it.
+     * @exception Exception if the history isn't empty
+     */
+    void setOrigin(const unsigned body_index);
+
+    /// Save absolute positions and velocities again (the default).
+    void unsetOrigin();
+
+    bool hasOrigin() const {
+        return origin_index >= 0;
+    }
+
+    /** Get the absolute position of the origin body at the saved state at
+     * index, or [0, 0, 0] if there is no origin.
+     */
+    physics::Vector originPosition(const unsigned index) const;
+
     /** Remove all history
      */
     void clear();
@@ -82,26 +238,97 @@ public:
         return times.size();
     }
 
+    /** Changes every time some saved states are removed, so that copies of
+     * the history (e.g. on the GPU) can tell when they are outdated.
+     */
+    unsigned long revision() const {
+        return revision_count;
+    }
+
     /** Get the position vector of the universe body at body_index (ranging
      * from 0 to SimulationHistory::universeSize) at the Nth saved simulation
      * state, where N is equal to index (ranging from 0 to
-     * SimulationHistory::historySize).
+     * SimulationHistory::historySize). Like all the positions returned from
+     * the history, it is relative to the origin body, if set.
      */
     QVector3D bodyPosition(const unsigned body_index,
                            const unsigned index) const;
 
+    /** Get the simulation time (in seconds) of the saved state at index.
+     */
+    physics::DOUBLE savedTime(const unsigned index) const;
+
+    /** Find the saved states surrounding the simulation time (in seconds),
+     * using a binary search. The time is clamped to the range of saved times.
+     * @exception Exception if the history is empty
+     */
+    HistoryPosition seek(const physics::DOUBLE time) const;
+
+    /** Get the positions of all bodies (one view per body index) saved
+     * between the times from and until (in seconds), including both. This
+     * doesn't copy any data, so even large windows can be extracted quickly.
+     * @param first_index: if not null, the index of the first state in the
+     *      window will be written there
+     */
+    std::vector<PositionSpan> window(const physics::DOUBLE from,
+                                     const physics::DOUBLE until,
+                                     unsigned *first_index = nullptr) const;
+
+    /** Evaluate the position of the body at body_index at an arbitrary
+     * simulation time (in seconds), not just at the saved states. It uses a
+     * cubic Hermite interpolation between the two neighbouring saved states,
+     * which uses both their positions and velocities, so the history can be
+     * saved quite sparsely and the animation still stays smooth. The time is
+     * clamped to the range of saved times.
+     */
+    QVector3D interpolatedBodyPosition(const unsigned body_index,
+                                       const physics::DOUBLE time) const;
+
+    /** Same as above, but use a position that was already found by
+     * SimulationHistory::seek - when evaluating all the bodies at the same
+     * time, the search has to be done only once.
+     */
+    QVector3D interpolatedBodyPosition(const unsigned body_index,
+                                       const HistoryPosition& position) const;
+
     /** Get the raw position history of body with body_index (ranging from 0 to
      * SimulationHistory::universeSize). This format is supposed to be suitable
      * to be copied by OpenGL into a buffer - it is possible because
      * std::vector guarantees continuity of data and it can be used as a raw C
      * array. The size of result will be SimulationHistory::historySize() * 3,
      * since each position is a vector of 3 floating point numbers.
+     *
+     * The result is only a view into the history, it doesn't copy anything,
+     * so it is cheap to call it even in every frame.
      */
-    const std::vector<GLfloat>& bodyPositions(const unsigned body_index) const;
+    PositionSpan bodyPositions(const unsigned body_index) const;
+
+    /** Same as SimulationHistory::bodyPositions(body_index), but read from a
+     * decimated level, which only contains every 2^level-th saved position.
+     * The Nth position in the result corresponds to the saved state at index
+     * `N * levelStride(level)`.
+     */
+    PositionSpan bodyPositions(const unsigned body_index,
+                               const unsigned level) const;
+
+    /// How many saved states are skipped between two positions of a level.
+    static unsigned levelStride(const unsigned level) {
+        return 1u << level;
+    }
+
+    /** Find the coarsest level whose stride isn't larger than `stride`, i.e.
+     * the level that loses no information needed when reading only every
+     * `stride`-th saved state. Returns 0 for stride 0 or 1.
+     */
+    static unsigned levelForStride(const unsigned stride);
 
 private:
     /// Stored in a format usable by an OpenGL buffer.
     std::vector<std::vector<GLfloat> > positions;
+    /** Decimated copies of positions, `decimated[level - 1][body_index]` for
+     * levels from 1 to HISTORY_LEVELS-1 (level 0 is positions itself).
+     */
+    std::vector<std::vector<std::vector<GLfloat> > > decimated;
     /// Stored in the same format as positions for convenience.
     std::vector<std::vector<GLfloat> > velocities;
     /** Save time information about the simulation, in seconds. The length
@@ -109,8 +336,19 @@ private:
      * each vertex. Should be always sorted from lowers to highest.
      */
     std::vector<physics::DOUBLE> times;
+    /// Sorted by Keyframe::index.
+    std::vector<Keyframe> keyframes;
     /// Number of bodies saved, i.e. number of items in positions.
     unsigned N = 0;
+    /// @see SimulationHistory::revision
+    unsigned long revision_count = 0;
+
+    /// Index of the origin body, or -1 if the positions are absolute.
+    int origin_index = -1;
+    /// Absolute position and velocity of the origin body, 3 numbers for each
+    /// saved state. Empty if there is no origin.
+    std::vector<double> origin_positions;
+    std::vector<double> origin_velocities;
 };
 
 #endif  // __SIMULATIONHISTORY_H__
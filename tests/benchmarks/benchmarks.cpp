@@ -0,0 +1,601 @@
+/*
+ * Copyright 2015 Martina Kollarova
+ *
+ * This file is part of NSim.
+ *
+ * NSim is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * NSim is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NSim. If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file
+ * Micro-benchmarks of the force kernel, each of the algorithms, the
+ * SimulationHistory, the Vector arithmetic and the ProjectParser for various
+ * numbers of bodies.
+ *
+ * Every benchmark is repeated until it runs at least the minimal time, in
+ * at least MIN_SAMPLES samples, so that the variance can be computed. The
+ * results are written in CSV, one row for each benchmark and number of
+ * bodies, with a label (e.g. the commit) to compare them between commits.
+ * Memory allocations are counted by replacing the global operator new, and
+ * the peak resident set size of each benchmark is read from /proc on Linux.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QString>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QDir>
+
+#include "algorithms/factory.h"
+#include "generators/generators.h"
+#include "physics/simulationtime.h"
+#include "simulationhistory.h"
+#include "projectparser.h"
+#include "exceptions.h"
+
+using std::cerr;
+using std::endl;
+
+static std::atomic<unsigned long> allocations(0);
+
+void* operator new(std::size_t size)
+{
+    allocations++;
+    if(void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+/// Default numbers of bodies.
+static const char DEFAULT_BODIES[] = "3,10,100,1000,10000,100000";
+
+/// Default minimal time of one benchmark in seconds.
+static const double DEFAULT_MIN_TIME = 0.5;
+
+/// Default maximal estimated time of one benchmark in seconds.
+static const double DEFAULT_MAX_TIME = 20;
+
+/// Minimal number of samples, at least 2 to get the variance.
+static const unsigned MIN_SAMPLES = 3;
+
+/// Minimal time of one sample in nanoseconds. Short benchmarks are called
+/// several times in one sample, so that the timer doesn't distort them.
+static const double MIN_SAMPLE_TIME = 1e6;
+
+/// Number of states saved and loaded in one repetition of the history
+/// benchmarks.
+static const unsigned HISTORY_STATES = 64;
+
+/// Used by the results, so that the compiler can't optimize them out.
+static volatile double sink;
+
+/// Gives access to the force kernel of algorithms::Base.
+class ForceKernel : public algorithms::Base
+{
+public:
+    using algorithms::Base::computeAcceleration;
+    algorithms::Type getType() override {
+        return algorithms::T_EULER;
+    }
+
+protected:
+    void computeStepImplementation(physics::UniverseModel*,
+                                   physics::DOUBLE) override {}
+};
+
+/// Start measuring the peak resident set size from the current one. Works
+/// only on Linux, elsewhere the peak is unknown anyway.
+static void resetPeakMemory()
+{
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+/// Peak resident set size of the process in kB since resetPeakMemory, or -1
+/// if it can't be read.
+static long peakMemory()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while(std::getline(status, line)) {
+        if(line.compare(0, 6, "VmHWM:") == 0)
+            return std::atol(line.c_str() + 6);
+    }
+    return -1;
+}
+
+/// Statistics of one benchmark with a given number of bodies.
+struct Result {
+    std::string benchmark;
+    unsigned bodies = 0;
+    unsigned samples = 0;
+    /// Number of calls in all the samples.
+    unsigned long repetitions = 0;
+    /// Time of one call in nanoseconds.
+    double mean = 0;
+    /// Standard deviation of the mean time of one call in a sample.
+    double stddev = 0;
+    /// Shortest mean time of one call in a sample.
+    double min = 0;
+    /// What the work is counted in, e.g. interactions of two bodies.
+    std::string unit;
+    /// Number of units of work done in one call.
+    double work = 0;
+    /// Memory allocations in one call.
+    double allocations = 0;
+    /// Peak resident set size of the process during the benchmark in kB,
+    /// -1 if unknown.
+    long peak_memory = -1;
+};
+
+class Benchmarks
+{
+public:
+    /**
+     * @param prefixes: only the benchmarks whose names start with one of
+     *      them are run, all of them if empty
+     */
+    Benchmarks(double min_time, double max_time, const QStringList& prefixes)
+        : min_time(min_time * 1e9), max_time(max_time * 1e9),
+          prefixes(prefixes) {}
+
+    /**
+     * Time the function `run` until it took at least the minimal time. The
+     * time is measured in samples of MIN_SAMPLE_TIME, with as many calls as
+     * needed. The function `prepare` is called before every call and isn't
+     * measured. The first call is only a warm-up, unless it was too long.
+     *
+     * @param complexity: exponent of the number of bodies in the time of one
+     *      call, used to skip the benchmarks that would take too long,
+     *      estimated from the previous number of bodies
+     * @param work: function returning the work done by the given number of
+     *      the last calls
+     * @return false if the benchmark was skipped or isn't enabled
+     */
+    bool measure(const std::string& benchmark, unsigned bodies,
+                 double complexity, const std::string& unit,
+                 std::function<double(unsigned long)> work,
+                 std::function<void()> run,
+                 std::function<void()> prepare = nullptr);
+
+    /// Whether the benchmark was chosen to run.
+    bool enabled(const std::string& benchmark) const;
+
+    const std::vector<Result>& results() const {
+        return all_results;
+    }
+
+private:
+    double min_time;
+    double max_time;
+    QStringList prefixes;
+    std::vector<Result> all_results;
+    /// The last result of each benchmark, used for the estimates.
+    std::map<std::string, Result> last_results;
+};
+
+bool
+Benchmarks::enabled(const std::string& benchmark) const
+{
+    bool enabled = prefixes.isEmpty();
+    for(const QString& prefix : prefixes) {
+        if(QString::fromStdString(benchmark).startsWith(prefix.trimmed()))
+            enabled = true;
+    }
+    return enabled;
+}
+
+bool
+Benchmarks::measure(const std::string& benchmark, unsigned bodies,
+                    double complexity, const std::string& unit,
+                    std::function<double(unsigned long)> work,
+                    std::function<void()> run,
+                    std::function<void()> prepare)
+{
+    if(!enabled(benchmark))
+        return false;
+
+    auto last = last_results.find(benchmark);
+    if(last != last_results.end()) {
+        const double estimate = last->second.mean * MIN_SAMPLES
+            * std::pow(double(bodies) / last->second.bodies, complexity);
+        if(estimate > max_time) {
+            cerr << benchmark << " with " << bodies << " bodies skipped,"
+                 << " it would take about " << estimate * 1e-9 << " s"
+                 << endl;
+            return false;
+        }
+    }
+
+    resetPeakMemory();
+    QElapsedTimer timer;
+    unsigned long allocated = 0;
+    // time of the calls, only the run function is measured
+    auto call = [&](unsigned long calls) {
+        double time = 0;
+        if(!prepare) {
+            const unsigned long allocations_before = allocations;
+            timer.start();
+            for(unsigned long i = 0; i < calls; i++)
+                run();
+            time = timer.nsecsElapsed();
+            allocated = allocations - allocations_before;
+            return time;
+        }
+        allocated = 0;
+        for(unsigned long i = 0; i < calls; i++) {
+            prepare();
+            const unsigned long allocations_before = allocations;
+            timer.start();
+            run();
+            time += timer.nsecsElapsed();
+            allocated += allocations - allocations_before;
+        }
+        return time;
+    };
+
+    const double warm_up_time = call(1);
+    const double warm_up_work = work(1);
+    const unsigned long warm_up_allocations = allocated;
+    const unsigned long calls = std::max(1.0, std::ceil(MIN_SAMPLE_TIME
+                                                        / warm_up_time));
+    std::vector<double> times;
+    double total_time = 0, total_work = 0;
+    unsigned long total_allocations = 0, total_calls = 0;
+    if(warm_up_time * MIN_SAMPLES >= min_time) {
+        // too long to be repeated only for a warm-up
+        times.push_back(warm_up_time);
+        total_time = warm_up_time;
+        total_work = warm_up_work;
+        total_allocations = warm_up_allocations;
+        total_calls = 1;
+    }
+    while(times.size() < MIN_SAMPLES || total_time < min_time) {
+        const double time = call(calls);
+        total_allocations += allocated;
+        total_work += work(calls);
+        times.push_back(time / calls);
+        total_time += time;
+        total_calls += calls;
+    }
+
+    Result result;
+    result.benchmark = benchmark;
+    result.bodies = bodies;
+    result.samples = times.size();
+    result.repetitions = total_calls;
+    result.mean = total_time / total_calls;
+    result.min = times.front();
+    for(const double time : times) {
+        result.stddev += (time - result.mean) * (time - result.mean);
+        result.min = std::min(result.min, time);
+    }
+    result.stddev = std::sqrt(result.stddev / (times.size() - 1));
+    result.unit = unit;
+    result.work = total_work / total_calls;
+    result.allocations = double(total_allocations) / total_calls;
+    result.peak_memory = peakMemory();
+    all_results.push_back(result);
+    last_results[benchmark] = result;
+
+    cerr << benchmark << " with " << bodies << " bodies: "
+         << result.mean / result.work << " ns per " << unit << ", "
+         << 1e9 / result.mean << " per second, +-"
+         << 100 * result.stddev / result.mean << " %, "
+         << result.allocations << " allocations, "
+         << result.peak_memory << " kB peak memory" << endl;
+    return true;
+}
+
+static physics::UniverseModel universe(unsigned bodies)
+{
+    generators::Parameters parameters;
+    parameters.model = generators::M_PLUMMER;
+    parameters.count = bodies;
+    parameters.mass = 2e30;
+    parameters.radius = 1e13;
+    parameters.seed = 1;
+    return generators::generate(parameters);
+}
+
+static void benchmarkForces(Benchmarks *benchmarks, unsigned bodies)
+{
+    auto model = universe(bodies);
+    ForceKernel kernel;
+    benchmarks->measure("force kernel", bodies, 2, "interaction",
+                        [&](unsigned long calls) {
+        return double(calls) * bodies * (bodies - 1);
+    },
+                        [&]() { kernel.computeAcceleration(&model); });
+}
+
+static void benchmarkAlgorithms(Benchmarks *benchmarks, unsigned bodies)
+{
+    // a day is short enough for the bodies of a Plummer sphere to not crash
+    const physics::DOUBLE time_step = 86400;
+    for(unsigned i = 0; i < algorithms::shortTypeName.size(); ++i) {
+        auto model = universe(bodies);
+        auto algorithm = algorithms::factory((algorithms::Type) i);
+        std::uint64_t evaluations = 0;
+        // the number of force evaluations differs in the first steps of the
+        // multi-step algorithms, so it is counted
+        benchmarks->measure(
+            "step " + algorithms::shortTypeName[i].toStdString(), bodies, 2,
+            "interaction",
+            [&](unsigned long) {
+                const auto done = algorithm->forceEvaluations() - evaluations;
+                evaluations = algorithm->forceEvaluations();
+                return double(done);
+            },
+            [&]() { algorithm->computeStep(&model, time_step); });
+    }
+}
+
+static void benchmarkHistory(Benchmarks *benchmarks, unsigned bodies)
+{
+    auto model = universe(bodies);
+    auto algorithm = algorithms::factory(algorithms::T_RK4);
+    SimulationHistory history;
+    physics::SimulationTime time;
+    // saves into an empty history, clearing it isn't measured
+    auto fill = [&]() {
+        time.setTime(0);
+        for(unsigned i = 0; i < HISTORY_STATES; i++) {
+            history.save(model, time, algorithm.get());
+            time.updateTime();
+        }
+    };
+    auto clear = [&]() { history.clear(); };
+    auto refill = [&]() {
+        clear();
+        fill();
+    };
+    const auto states = [](unsigned long calls) {
+        return double(calls) * HISTORY_STATES;
+    };
+
+    benchmarks->measure("history save", bodies, 1, "state", states, fill,
+                        clear);
+    refill();
+    benchmarks->measure("history load", bodies, 1, "state", states, [&]() {
+        for(unsigned i = 0; i < HISTORY_STATES; i++)
+            history.load(i, &model, &time);
+    });
+    benchmarks->measure("history clear", bodies, 1, "state", states, clear,
+                        refill);
+}
+
+static void benchmarkVectors(Benchmarks *benchmarks, unsigned bodies)
+{
+    const auto model = universe(bodies);
+    std::vector<physics::Vector> a(bodies), b(bodies), c(bodies);
+    for(unsigned i = 0; i < bodies; i++) {
+        a[i] = model[i].position;
+        b[i] = model[i].velocity;
+    }
+    benchmarks->measure("vector arithmetic", bodies, 1, "vector",
+                        [&](unsigned long calls) {
+        return double(calls) * bodies;
+    }, [&]() {
+        physics::DOUBLE sum = 0;
+        for(unsigned i = 0; i < bodies; i++) {
+            c[i] = a[i] + b[i] * 0.5;
+            sum += physics::dotproduct(c[i], a[i]) + physics::abs(b[i]);
+        }
+        sink = sum;
+    });
+}
+
+static void benchmarkParse(Benchmarks *benchmarks, unsigned bodies)
+{
+    // the file is large, so it isn't written for nothing
+    if(!benchmarks->enabled("parse"))
+        return;
+    QTemporaryFile file(QDir::tempPath() + "/nsim-benchmark-XXXXXX.xml");
+    if(!file.open())
+        throw Exception("Could not create a temporary project file.");
+    {
+        // freed before the parser is measured, to not count in its memory
+        const auto model = universe(bodies);
+        QTextStream stream(&file);
+        stream.setRealNumberPrecision(17);
+        stream << "<nsim>\n"
+               << "    <settings>\n"
+               << "        <units>\n"
+               << "            <mass> kg </mass>\n"
+               << "            <length> m </length>\n"
+               << "            <time> sec </time>\n"
+               << "        </units>\n"
+               << "    </settings>\n"
+               << "    <universe count=\"" << bodies << "\">\n";
+        for(const auto& body : model) {
+            stream << "        <body>\n"
+                   << "            <radius> " << double(body.radius)
+                   << " </radius>\n"
+                   << "            <mass> " << double(body.mass)
+                   << " </mass>\n"
+                   << "            <position> " << double(body.position[0])
+                   << ", " << double(body.position[1]) << ", "
+                   << double(body.position[2]) << " </position>\n"
+                   << "            <velocity> " << double(body.velocity[0])
+                   << ", " << double(body.velocity[1]) << ", "
+                   << double(body.velocity[2]) << " </velocity>\n"
+                   << "        </body>\n";
+        }
+        stream << "    </universe>\n"
+               << "</nsim>\n";
+        stream.flush();
+        if(stream.status() != QTextStream::Ok)
+            throw Exception("Could not write the temporary project file.");
+    }
+    file.close();
+
+    benchmarks->measure("parse", bodies, 1, "body",
+                        [&](unsigned long calls) {
+        return double(calls) * bodies;
+    }, [&]() {
+        parser::ProjectParser parser(file.fileName());
+        sink = parser.getUniverseModel().size();
+    });
+}
+
+static void writeResults(const std::vector<Result>& results,
+                         const std::string& label, std::ostream *output)
+{
+    output->precision(10);
+    *output << "label,benchmark,bodies,samples,repetitions,mean [ns],"
+            << "stddev [ns],min [ns],unit,ns per unit,per second,"
+            << "allocations,peak memory [kB]\n";
+    for(const auto& result : results) {
+        *output << label << ',' << result.benchmark << ','
+                << result.bodies << ',' << result.samples << ','
+                << result.repetitions << ','
+                << result.mean << ',' << result.stddev << ','
+                << result.min << ',' << result.unit << ','
+                << result.mean / result.work << ','
+                << 1e9 / result.mean << ',' << result.allocations << ','
+                << result.peak_memory << '\n';
+    }
+    output->flush();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("NSim");
+    QCoreApplication::setApplicationVersion("1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measure the speed of the force kernel,"
+                                     " the algorithms, the simulation history,"
+                                     " vectors and the project parser and"
+                                     " print it in CSV format.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOptions({
+        {   {"n", "bodies"},
+            QCoreApplication::translate("main",
+            "Comma separated numbers of bodies. Default is ")
+            + DEFAULT_BODIES + ".",
+            QCoreApplication::translate("main", "counts")
+        },
+        {   {"b", "benchmarks"},
+            QCoreApplication::translate("main",
+            "Run only the benchmarks whose names start with one of the comma"
+            " separated prefixes, e.g. 'force,step rk4'."),
+            QCoreApplication::translate("main", "names")
+        },
+        {   "min-time",
+            QCoreApplication::translate("main",
+            "Minimal time of one benchmark in seconds. Default is ")
+            + QString::number(DEFAULT_MIN_TIME) + ".",
+            QCoreApplication::translate("main", "seconds")
+        },
+        {   "max-time",
+            QCoreApplication::translate("main",
+            "Skip the benchmarks estimated to take longer, in seconds."
+            " Default is ") + QString::number(DEFAULT_MAX_TIME) + ".",
+            QCoreApplication::translate("main", "seconds")
+        },
+        {   {"l", "label"},
+            QCoreApplication::translate("main",
+            "Label of the results in the first column, e.g. the commit."),
+            QCoreApplication::translate("main", "label")
+        },
+        {   {"o", "output"},
+            QCoreApplication::translate("main",
+            "Write the results to the file instead of the standard output."),
+            QCoreApplication::translate("main", "file")
+        }
+    });
+    parser.process(app);
+
+    bool failed = false;
+    try {
+        std::vector<unsigned> counts;
+        const QString bodies = parser.isSet("bodies")
+                               ? parser.value("bodies")
+                               : QString(DEFAULT_BODIES);
+        for(const QString& count : bodies.split(",")) {
+            bool ok;
+            counts.push_back(count.toUInt(&ok));
+            if(!ok || counts.back() < 2)
+                throw Exception("Invalid number of bodies " + count);
+        }
+        double min_time = DEFAULT_MIN_TIME, max_time = DEFAULT_MAX_TIME;
+        bool ok = true;
+        if(parser.isSet("min-time"))
+            min_time = parser.value("min-time").toDouble(&ok);
+        if(ok && parser.isSet("max-time"))
+            max_time = parser.value("max-time").toDouble(&ok);
+        if(!ok || min_time < 0 || max_time <= 0)
+            throw Exception("Invalid time limit.");
+
+        Benchmarks benchmarks(min_time, max_time,
+                              parser.value("benchmarks").split(
+                                  ",", QString::SkipEmptyParts));
+        void (*const groups[])(Benchmarks*, unsigned) = {
+            benchmarkForces, benchmarkAlgorithms, benchmarkHistory,
+            benchmarkVectors, benchmarkParse
+        };
+        for(const unsigned count : counts) {
+            for(const auto group : groups) {
+                // the results of the others are still worth writing
+                try {
+                    group(&benchmarks, count);
+                } catch(const Exception& e) {
+                    cerr << "ERROR: " << e.what() << endl;
+                    failed = true;
+                }
+            }
+        }
+
+        std::ofstream file;
+        if(parser.isSet("output")) {
+            file.open(parser.value("output").toStdString(),
+                      std::ios::out | std::ios::trunc);
+            if(!file)
+                throw Exception("Could not open the output file "
+                                + parser.value("output"));
+        }
+        std::ostream& output = file.is_open() ? file : std::cout;
+        writeResults(benchmarks.results(),
+                     parser.value("label").toStdString(), &output);
+        if(!output)
+            throw Exception("Could not write the results.");
+    } catch(const Exception& e) {
+        cerr << "ERROR: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,23 @@
+# micro-benchmarks of the force kernel, the algorithms, the history and the
+# project parser
+TARGET = nsim-benchmarks
+
+include("../../common.pri")
+INCLUDEPATH += $$PROJ_DIR"/src/"
+
+# the results are meaningless without optimizations
+CONFIG += console release
+CONFIG -= debug
+
+SOURCES +=  benchmarks.cpp\
+
+# files not included in common.pri
+HEADERS += $$PROJ_DIR"/src/simulationhistory.h"\
+           $$PROJ_DIR"/src/projectparser.h"\
+           $$PROJ_DIR"/src/horizons.h"\
+           $$PROJ_DIR"/src/bodytable.h"\
+
+SOURCES += $$PROJ_DIR"/src/simulationhistory.cpp"\
+           $$PROJ_DIR"/src/projectparser.cpp"\
+           $$PROJ_DIR"/src/horizons.cpp"\
+           $$PROJ_DIR"/src/bodytable.cpp"\
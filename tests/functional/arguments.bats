@@ -54,3 +54,90 @@ RESULT=$BATS_TMPDIR"/result.csv"
     $CMD -f $FILE -b > $RESULT
     $DIFF --epsilon 0.01 $EXPECTED $RESULT
 }
+
+@test "output in AU and days" {
+    # the same bodies as earth-moon-sun.xml, in AU and days
+    $CMD -f $EXAMPLE_FILES"/earth-moon-sun.xml" | tail -n 1 > $RESULT
+    $CMD -f $TEST_FILES"/earth-moon-sun-au.xml" | tail -n 1 \
+        | awk -v AU=1.495978707e8 -v OFMT=%.17g -v CONVFMT=%.17g '{
+            $1 *= 86400;
+            for(i = 2; i <= NF; i++) $i *= AU;
+            print }' > $RESULT".au"
+    paste -d " " $RESULT $RESULT".au" | awk '{
+        n = NF / 2;
+        for(i = 1; i <= n; i++) {
+            d = $i - $(i + n);
+            if(d * d > 1e-18 * ($i * $i + 1)) exit 1;
+        } }'
+}
+
+@test "invalid output format" {
+    run $CMD -f $EXAMPLE_FILES"/earth-moon-sun.xml" --output-format xyz
+    [ $status -eq 1 ]
+    [[ "$output" =~ "Invalid output format." ]]
+}
+
+@test "npy output to a file" {
+    RESULT=$BATS_TMPDIR"/result.npy"
+    for FORMAT in npy npy-body-major; do
+        $CMD -f $EXAMPLE_FILES"/earth-moon-sun.xml" \
+            --output-format $FORMAT -o $RESULT
+        [ "$(head -c 6 $RESULT | tail -c 5)" = "NUMPY" ]
+        # 11 steps with the time and 3 bodies, after a 64 byte aligned header
+        SIZE=$(stat -c %s $RESULT)
+        [ $(( (SIZE - 11 * 10 * 8) % 64 )) -eq 0 ]
+    done
+}
+
+@test "npy unit labels" {
+    # the unit names in the npy header belong to the written numbers
+    $CMD -f $TEST_FILES"/earth-moon-sun-au.xml" --output-format npy \
+        -o $RESULT".npy"
+    grep -a -q "Earth position \[AU\]" $RESULT".npy"
+    grep -a -q "time \[day\]" $RESULT".npy"
+}
+
+@test "compressed output" {
+    FILE=$EXAMPLE_FILES"/earth-moon-sun.xml"
+    $CMD -f $FILE > $RESULT
+    $CMD -f $FILE -z -o $RESULT".z"
+    $DECOMPRESS $RESULT".z" | cmp - $RESULT
+    $CMD -f $FILE --compress | $DECOMPRESS | cmp - $RESULT
+}
+
+@test "bodies loaded from CSV and binary tables" {
+    $CMD -f $EXAMPLE_FILES"/earth-moon-sun.xml" | tail -n +2 > $RESULT
+    for FORMAT in csv bin; do
+        # the bodies in the tables don't have names, so the header differs
+        $CMD -f $TEST_FILES"/earth-moon-sun-"$FORMAT".xml" | tail -n +2 \
+            | cmp - $RESULT
+    done
+}
+
+@test "validation against the HORIZONS tables" {
+    FILE=$EXAMPLE_FILES"/solar-system-horizons.xml"
+    $VALIDATE $FILE -a euler,rk4 -s 3600 -t 10 -i 5 -o $RESULT
+    # the header and two comparisons for each algorithm
+    [ $(wc -l < $RESULT) -eq 5 ]
+    # 11 bodies, 240 steps with 4 evaluations of 10 forces on each body
+    [ $(grep "^rk4,3600,864000," $RESULT | cut -d, -f5) -eq 105600 ]
+    [ $(grep "^euler,3600,864000," $RESULT | cut -d, -f5) -eq 26400 ]
+}
+
+@test "validation needs bodies from HORIZONS" {
+    run $VALIDATE $EXAMPLE_FILES"/earth-moon-sun.xml"
+    [ $status -eq 1 ]
+    [[ "$output" =~ "No bodies with a <horizons> tag" ]]
+}
+
+@test "invalid trail memory budget" {
+    PROJECT=$BATS_TMPDIR"/budget.xml"
+    for BUDGET in 4096 1e-9 -1; do
+        TAG="<trail-memory-budget>$BUDGET</trail-memory-budget>"
+        sed "s|</settings>|$TAG&|" $EXAMPLE_FILES"/earth-moon-sun.xml" \
+            > $PROJECT
+        run $CMD -f $PROJECT
+        [ $status -eq 1 ]
+        [[ "$output" =~ "trail memory budget" ]]
+    done
+}
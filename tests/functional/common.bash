@@ -4,3 +4,5 @@ CMD=$PROJ_DIR"/bin/nsim-cmd -t 2000 -s 10 -p 200"
 EXAMPLE_FILES=$PROJ_DIR"/examples"
 TEST_FILES=$BATS_TEST_DIRNAME"/files"
 DIFF=$PROJ_DIR"/tools/data_diff"
+DECOMPRESS=$PROJ_DIR"/bin/nsim-decompress"
+VALIDATE=$PROJ_DIR"/bin/nsim-validate"
@@ -99,3 +99,60 @@ TEST_CASE("Check that a single planet moves correctly", "[algorithms]")
     REQUIRE(universe[0].position == physics::Vector(1, 0, 0));
     REQUIRE(universe[0].velocity == physics::Vector(1, 0, 0));
 }
+
+/*
+ * Two planets orbiting each other. When the computation of a multi-step
+ * algorithm is interrupted and continued by a new instance of the algorithm,
+ * using the saved history, the results have to be exactly the same.
+ */
+TEST_CASE("Resume multi-step algorithms from their history", "[algorithms]")
+{
+    physics::Body planet1, planet2;
+    planet1.mass = 1e20;
+    planet2.mass = 1e20;
+    planet2.position.set(1e7, 0, 0);
+    planet2.velocity.set(0, 10, 0);
+    physics::UniverseModel universe {planet1, planet2};
+    physics::SimulationTime time;
+
+    algorithms::AdamsBashforthMoulton alg {8};
+    for(unsigned i = 0; i < 5; i++)
+        alg.computeStep(&universe, time.timeStep());
+    physics::UniverseModel resumed_universe = universe;
+    algorithms::AdamsBashforthMoulton resumed {8};
+    resumed.setHistory(alg.getHistory());
+
+    for(unsigned i = 0; i < 10; i++) {
+        alg.computeStep(&universe, time.timeStep());
+        resumed.computeStep(&resumed_universe, time.timeStep());
+    }
+    for(unsigned i = 0; i < universe.size(); i++) {
+        REQUIRE(universe[i].position.x() == resumed_universe[i].position.x());
+        REQUIRE(universe[i].velocity.y() == resumed_universe[i].velocity.y());
+    }
+    REQUIRE(algorithms::Euler().getHistory().empty());
+}
+
+TEST_CASE("Count the evaluations of forces between bodies", "[algorithms]")
+{
+    physics::Body planet1, planet2, planet3;
+    planet1.mass = planet2.mass = planet3.mass = 1e20;
+    planet2.position.set(1e7, 0, 0);
+    planet3.position.set(0, 1e7, 0);
+    physics::UniverseModel universe {planet1, planet2, planet3};
+    physics::SimulationTime time;
+
+    // each of the 3 bodies is attracted by the 2 others
+    algorithms::Euler euler;
+    euler.computeStep(&universe, time.timeStep());
+    REQUIRE(euler.forceEvaluations() == 6);
+
+    algorithms::RungeKutta rk4 {4};
+    rk4.computeStep(&universe, time.timeStep());
+    REQUIRE(rk4.forceEvaluations() == 4 * 6);
+
+    // the first steps are computed by Runge-Kutta
+    algorithms::AdamsBashforth ab4 {4};
+    ab4.computeStep(&universe, time.timeStep());
+    REQUIRE(ab4.forceEvaluations() == 6 + 4 * 6);
+}
@@ -0,0 +1,102 @@
+#include "catch.h"
+#include <cmath>
+#include "generators/generators.h"
+#include "algorithms/base.h"
+#include "physics/universemodel.h"
+
+
+static physics::UniverseModel generate(generators::Model model,
+                                       unsigned count, std::uint64_t seed = 1)
+{
+    generators::Parameters parameters;
+    parameters.model = model;
+    parameters.count = count;
+    parameters.mass = 2e30;
+    parameters.radius = 1e11;
+    parameters.seed = seed;
+    return generators::generate(parameters);
+}
+
+TEST_CASE("Generated universes are reproducible", "[generators]")
+{
+    // enough bodies to use several threads
+    const unsigned count = 50000;
+    auto first = generate(generators::M_PLUMMER, count, 7);
+    auto second = generate(generators::M_PLUMMER, count, 7);
+    auto other = generate(generators::M_PLUMMER, count, 8);
+    REQUIRE(first.size() == count);
+    bool same = true, different = false;
+    for(unsigned i = 0; i < count; i++) {
+        same = same && first[i].position == second[i].position
+               && first[i].velocity == second[i].velocity;
+        different = different || first[i].position != other[i].position;
+    }
+    REQUIRE(same);
+    REQUIRE(different);
+}
+
+TEST_CASE("Generated universes are at rest in the origin", "[generators]")
+{
+    for(auto model : {generators::M_PLUMMER, generators::M_UNIFORM_CUBE,
+                      generators::M_COLD_COLLAPSE}) {
+        auto universe = generate(model, 1000);
+        physics::DOUBLE mass = 0;
+        physics::Vector position, momentum;
+        for(const auto& body : universe) {
+            mass += body.mass;
+            position += body.position * body.mass;
+            momentum += body.velocity * body.mass;
+        }
+        REQUIRE(std::fabs(mass / 2e30 - 1) < 1e-12);
+        REQUIRE(physics::abs(position / mass) < 1);
+        REQUIRE(physics::abs(momentum / mass) < 1e-6);
+    }
+}
+
+TEST_CASE("Shapes of the generated universes", "[generators]")
+{
+    auto plummer = generate(generators::M_PLUMMER, 1000);
+    for(const auto& body : plummer)
+        REQUIRE(physics::abs(body.position) < 11e11);
+
+    auto cube = generate(generators::M_UNIFORM_CUBE, 1000);
+    for(const auto& body : cube) {
+        for(int i = 0; i < 3; i++)
+            REQUIRE(std::fabs(body.position[i]) < 2e11);
+    }
+
+    // the center of mass is moved to the origin, so the radius can grow
+    auto collapse = generate(generators::M_COLD_COLLAPSE, 1000);
+    for(const auto& body : collapse) {
+        REQUIRE(physics::abs(body.position) < 1.1e11);
+        REQUIRE(physics::abs(body.velocity) < 1e-6);
+    }
+}
+
+TEST_CASE("Kepler disk has circular orbits", "[generators]")
+{
+    auto disk = generate(generators::M_KEPLER_DISK, 1000);
+    REQUIRE(disk[0].mass == 2e30);
+    REQUIRE(physics::abs(disk[0].position) == 0);
+    for(unsigned i = 1; i < disk.size(); i++) {
+        const auto& body = disk[i];
+        const physics::DOUBLE r = physics::abs(body.position);
+        REQUIRE(r >= 1e10 * (1 - 1e-9));
+        REQUIRE(r <= 1e11);
+        REQUIRE(body.position.z() == 0);
+        const physics::DOUBLE v = std::sqrt(algorithms::G * 2e30 / r);
+        REQUIRE(std::fabs(physics::abs(body.velocity) / v - 1) < 1e-9);
+        REQUIRE(std::fabs(physics::dotproduct(body.position, body.velocity)
+                          / (r * v)) < 1e-9);
+    }
+}
+
+TEST_CASE("Invalid generator parameters", "[generators]")
+{
+    generators::Parameters parameters;
+    parameters.count = 0;
+    REQUIRE_THROWS(generators::generate(parameters));
+    parameters.count = 10;
+    parameters.radius = -1;
+    REQUIRE_THROWS(generators::generate(parameters));
+}
@@ -0,0 +1,86 @@
+#include "catch.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include "horizons.h"
+
+
+// circular orbit with the radius of 1 AU (in km) and a period of a year
+static const double RADIUS = 1.496e8;
+static const double OMEGA = 2 * M_PI / (365.25 * 86400);
+static const double FIRST_DAY = 2443376.5;
+
+static physics::Vector position(double day)
+{
+    const double angle = OMEGA * (day - FIRST_DAY) * 86400;
+    return physics::Vector(RADIUS * std::cos(angle),
+                           RADIUS * std::sin(angle), 0) * 1000;
+}
+
+static physics::Vector velocity(double day)
+{
+    const double angle = OMEGA * (day - FIRST_DAY) * 86400;
+    return physics::Vector(-RADIUS * OMEGA * std::sin(angle),
+                           RADIUS * OMEGA * std::cos(angle), 0) * 1000;
+}
+
+static std::vector<parser::StateVector> table(unsigned days)
+{
+    std::vector<parser::StateVector> rows(days);
+    for(unsigned i = 0; i < days; i++) {
+        rows[i].julian_date = FIRST_DAY + i;
+        rows[i].position = position(FIRST_DAY + i);
+        rows[i].velocity = velocity(FIRST_DAY + i);
+    }
+    return rows;
+}
+
+TEST_CASE("States are interpolated between the rows", "[horizons]")
+{
+    const auto rows = table(10);
+    SECTION("Rows are returned as they are") {
+        auto state = parser::horizonsState(rows, FIRST_DAY + 3);
+        REQUIRE(state.position == rows[3].position);
+        REQUIRE(state.velocity == rows[3].velocity);
+    }
+    SECTION("Interpolation error is below 1e-9 of the orbit") {
+        for(double day = FIRST_DAY; day < FIRST_DAY + 9; day += 0.1) {
+            auto state = parser::horizonsState(rows, day);
+            const double position_error = physics::abs(state.position
+                                                       - position(day));
+            const double velocity_error = physics::abs(state.velocity
+                                                       - velocity(day));
+            REQUIRE(position_error < 100);
+            REQUIRE(velocity_error < 1e-2);
+        }
+    }
+    SECTION("Times outside of the table are refused") {
+        REQUIRE_THROWS(parser::horizonsState(rows, FIRST_DAY - 1));
+        REQUIRE_THROWS(parser::horizonsState(rows, FIRST_DAY + 10));
+    }
+}
+
+TEST_CASE("Tables from HORIZONS are read", "[horizons]")
+{
+    const std::string file_name = "test_horizons.txt";
+    {
+        std::ofstream file(file_name);
+        file << "# JDCT, time, x, y, z, vx, vy, vz\n"
+             << "$$SOE\n"
+             << "2443377.5, A.D. 1977-Aug-22 00:00:00.0000,  4.0E+03,"
+                " 5.0E+03, 6.0E+03, -1.0E+00, -2.0E+00, -3.0E+00,\n"
+             << "2443376.5, A.D. 1977-Aug-21 00:00:00.0000,  1.0E+03,"
+                " 2.0E+03, 3.0E+03,  1.0E+00,  2.0E+00,  3.0E+00,\n"
+             << "$$EOE\n"
+             << "2443378.5, this is a footer, 1, 2, 3, 4, 5, 6,\n";
+    }
+    auto rows = parser::readHorizonsTable(file_name.c_str());
+    std::remove(file_name.c_str());
+    REQUIRE(rows.size() == 2);
+    // sorted by time and converted to meters
+    REQUIRE(rows[0].julian_date == 2443376.5);
+    REQUIRE(rows[0].position == physics::Vector(1e6, 2e6, 3e6));
+    REQUIRE(rows[0].velocity == physics::Vector(1e3, 2e3, 3e3));
+    REQUIRE(rows[1].position == physics::Vector(4e6, 5e6, 6e6));
+    REQUIRE_THROWS(parser::readHorizonsTable("missing_horizons.txt"));
+}
@@ -0,0 +1,249 @@
+#include "catch.h"
+#include <sstream>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <cstring>
+#include "output/textwriter.h"
+#include "output/npywriter.h"
+#include "output/asyncwriter.h"
+#include "output/compression.h"
+#include "physics/universemodel.h"
+
+
+static physics::UniverseModel twoBodies()
+{
+    physics::UniverseModel universe(2);
+    universe[0].name = "Sun";
+    universe[0].position = physics::Vector(1, 2, 3);
+    universe[1].name = "Earth";
+    universe[1].position = physics::Vector(1.5e11, -2.25, 1.0/3.0);
+    return universe;
+}
+
+TEST_CASE("Text output header", "[output]")
+{
+    std::ostringstream stream;
+    output::TextWriter writer(&stream);
+    writer.writeHeader(twoBodies());
+    writer.flush();
+    REQUIRE(stream.str() == "# time Sun_x Sun_y Sun_z Earth_x Earth_y Earth_z\n");
+}
+
+TEST_CASE("Text output of steps", "[output]")
+{
+    std::ostringstream stream;
+    output::Units units;
+    units.time_divisor = 0.5;
+    units.length_divisor = 2;
+    output::TextWriter writer(&stream, units);
+    auto universe = twoBodies();
+    writer.writeStep(100, universe, physics::Vector(1, 1, 1));
+    // nothing is written until the block is full or flushed
+    REQUIRE(stream.str().empty());
+    writer.flush();
+
+    std::ostringstream expected;
+    expected.precision(15);
+    expected << physics::DOUBLE(200) << " 0 0.5 1 "
+             << physics::DOUBLE(0.5e11 * 1.5 - 0.5) << " "
+             << physics::DOUBLE(-3.25 * 0.5) << " "
+             << physics::DOUBLE((1.0/3.0 - 1) * 0.5) << "\n";
+    REQUIRE(stream.str() == expected.str());
+    REQUIRE(writer.writtenBytes() == expected.str().size());
+}
+
+TEST_CASE("Text output is written in blocks", "[output]")
+{
+    std::ostringstream stream;
+    auto universe = twoBodies();
+    std::size_t length;
+    {
+        output::TextWriter writer(&stream, output::Units(), 64);
+        for(int i = 0; i < 100; i++)
+            writer.writeStep(i, universe, physics::Vector());
+        length = stream.str().size();
+        REQUIRE(length > 0);
+        REQUIRE(length == writer.writtenBytes());
+    }
+    // the destructor writes the rest
+    REQUIRE(stream.str().size() > length);
+
+    std::istringstream lines(stream.str());
+    std::string line;
+    int count = 0;
+    while(std::getline(lines, line)) {
+        std::istringstream numbers(line);
+        double time, value;
+        numbers >> time;
+        REQUIRE(time == count);
+        int values = 0;
+        while(numbers >> value) values++;
+        REQUIRE(values == 6);
+        count++;
+    }
+    REQUIRE(count == 100);
+}
+
+static std::vector<double> npyData(const std::string& file,
+                                   std::size_t *header_size)
+{
+    REQUIRE(file.compare(0, 6, "\x93NUMPY") == 0);
+    REQUIRE(file[6] == 1);
+    const std::size_t size = 10 + (unsigned char)file[8]
+                             + 256 * (unsigned char)file[9];
+    REQUIRE((size % 64) == 0);
+    REQUIRE(file[size - 1] == '\n');
+    REQUIRE(((file.size() - size) % sizeof(double)) == 0);
+    std::vector<double> data((file.size() - size) / sizeof(double));
+    std::memcpy(data.data(), file.data() + size, data.size() * sizeof(double));
+    *header_size = size;
+    return data;
+}
+
+TEST_CASE("NumPy output header", "[output]")
+{
+    output::Units units;
+    units.length_name = "km";
+    auto universe = twoBodies();
+    universe[1].name = "Sun";
+    const std::string header = output::NpyWriter::header(
+        universe, 7, output::NpyWriter::TIME_MAJOR, units);
+    // duplicate names get a suffix, the units are in the titles
+    REQUIRE(header.find("(('time [s]', 'time'), '<f8')") != std::string::npos);
+    REQUIRE(header.find("(('Sun position [km]', 'Sun'), '<f8', (3,))")
+            != std::string::npos);
+    REQUIRE(header.find("'Sun_1'") != std::string::npos);
+    REQUIRE(header.find("'shape': (7,)") != std::string::npos);
+
+    const std::string body_major = output::NpyWriter::header(
+        universe, 7, output::NpyWriter::BODY_MAJOR, units);
+    REQUIRE(body_major.find("'<f8', (7, 3))") != std::string::npos);
+    REQUIRE(body_major.find("'shape': ()") != std::string::npos);
+}
+
+TEST_CASE("NumPy output layouts", "[output]")
+{
+    auto universe = twoBodies();
+    const unsigned steps = 5;
+    for(auto layout : {output::NpyWriter::TIME_MAJOR,
+                       output::NpyWriter::BODY_MAJOR}) {
+        // the body-major layout seeks past the end of the file
+        const std::string file_name = "test_output.npy";
+        std::fstream stream(file_name, std::ios::in | std::ios::out
+                            | std::ios::trunc | std::ios::binary);
+        {
+            // blocks of two steps
+            output::NpyWriter writer(&stream, steps, layout, output::Units(),
+                                     2 * 7 * sizeof(double));
+            writer.writeHeader(universe);
+            for(unsigned i = 0; i < steps; i++) {
+                universe[1].position[0] = i;
+                writer.writeStep(10 * i, universe, physics::Vector());
+            }
+            writer.flush();
+        }
+        stream.seekg(0);
+        const std::string file((std::istreambuf_iterator<char>(stream)),
+                               std::istreambuf_iterator<char>());
+        std::remove(file_name.c_str());
+        std::size_t header_size;
+        const auto data = npyData(file, &header_size);
+        REQUIRE(data.size() == steps * 7);
+        for(unsigned i = 0; i < steps; i++) {
+            if(layout == output::NpyWriter::TIME_MAJOR) {
+                REQUIRE(data[i * 7] == 10 * i);
+                REQUIRE(data[i * 7 + 1] == 1);
+                REQUIRE(data[i * 7 + 4] == i);
+                REQUIRE(data[i * 7 + 5] == -2.25);
+            } else {
+                REQUIRE(data[i] == 10 * i);
+                REQUIRE(data[steps + i * 3] == 1);
+                REQUIRE(data[steps + i * 3 + 2] == 3);
+                REQUIRE(data[4 * steps + i * 3] == i);
+                REQUIRE(data[4 * steps + i * 3 + 1] == -2.25);
+            }
+        }
+    }
+}
+
+TEST_CASE("Asynchronous output", "[output]")
+{
+    auto universe = twoBodies();
+    std::ostringstream expected, result;
+    {
+        output::TextWriter writer(&expected);
+        writer.writeHeader(universe);
+        for(int i = 0; i < 1000; i++) {
+            universe[0].position[1] = i;
+            writer.writeStep(i, universe, physics::Vector(0, 0, i));
+        }
+    }
+    {
+        // blocks of 3 steps, so the buffers are reused many times
+        std::unique_ptr<output::Writer> text(new output::TextWriter(&result));
+        output::AsyncWriter writer(std::move(text),
+                                   3 * 10 * sizeof(physics::DOUBLE));
+        writer.writeHeader(universe);
+        for(int i = 0; i < 500; i++) {
+            universe[0].position[1] = i;
+            writer.writeStep(i, universe, physics::Vector(0, 0, i));
+        }
+        writer.flush();
+        REQUIRE(result.str() == expected.str().substr(0, result.str().size()));
+        for(int i = 500; i < 1000; i++) {
+            universe[0].position[1] = i;
+            writer.writeStep(i, universe, physics::Vector(0, 0, i));
+        }
+    }
+    REQUIRE(result.str() == expected.str());
+}
+
+TEST_CASE("Asynchronous output errors", "[output]")
+{
+    std::ostringstream stream;
+    stream.setstate(std::ios::badbit);
+    std::unique_ptr<output::Writer> text(
+        new output::TextWriter(&stream, output::Units(), 64));
+    output::AsyncWriter writer(std::move(text), 64);
+    auto universe = twoBodies();
+    writer.writeHeader(universe);
+    // the error happens in the thread and is thrown later in this one
+    auto write = [&]() {
+        for(int i = 0; i < 100; i++)
+            writer.writeStep(i, universe, physics::Vector());
+        writer.flush();
+    };
+    REQUIRE_THROWS(write());
+}
+
+TEST_CASE("Compressed output", "[output]")
+{
+    std::string text;
+    for(int i = 0; i < 1000; i++)
+        text += std::to_string(i * 200) + " 0 0 0 1.5e11 -2.25 0.333\n";
+
+    std::ostringstream compressed;
+    {
+        // small blocks, so there are many frames
+        output::CompressingBuffer buffer(&compressed, -1, 1000);
+        std::ostream stream(&buffer);
+        stream << text.substr(0, 5000);
+        stream.flush();
+        stream << text.substr(5000);
+        buffer.finish();
+    }
+    REQUIRE(compressed.str().size() < text.size() / 2);
+
+    std::istringstream input(compressed.str());
+    std::ostringstream result;
+    output::decompress(&input, &result);
+    REQUIRE(result.str() == text);
+
+    // everything but the end of the stream
+    const std::string data = compressed.str();
+    std::istringstream truncated(data.substr(0, data.size() - 4));
+    REQUIRE_THROWS(output::decompress(&truncated, &result));
+    std::istringstream plain(text);
+    REQUIRE_THROWS(output::decompress(&plain, &result));
+}
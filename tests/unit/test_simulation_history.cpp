@@ -5,6 +5,7 @@
 #include "physics/simulationtime.h"
 #include "physics/vector.h"
 #include "physics/precision.h"
+#include "algorithms/adams-bashforth.h"
 
 
 TEST_CASE("Empty simulation history")
@@ -103,6 +104,34 @@ TEST_CASE("Normal usage")
         }
     }
 
+    SECTION("View part of the raw data") {
+        PositionSpan span = history.bodyPositions(0).subspan(1, 5);
+        REQUIRE(span.vertexCount() == 2);
+        REQUIRE(span.data() == history.bodyPositions(0).data() + 3);
+        REQUIRE(qFuzzyCompare(span.vertex(1), QVector3D(6, 6, 6)));
+        REQUIRE(history.bodyPositions(0).subspan(4, 1).empty());
+    }
+
+    SECTION("Get decimated data") {
+        const float expected[] = {1,2,3, 6,6,6};
+        auto result = history.bodyPositions(0, 1);
+        REQUIRE(result.size() == 2 * 3);
+        for(unsigned i = 0; i < result.size(); i++) {
+            REQUIRE(physics::equal(expected[i], result[i]));
+        }
+        REQUIRE(history.bodyPositions(0, 2).size() == 1 * 3);
+        REQUIRE_THROWS(history.bodyPositions(0, HISTORY_LEVELS));
+    }
+
+    SECTION("Choose level by stride") {
+        REQUIRE(SimulationHistory::levelForStride(0) == 0);
+        REQUIRE(SimulationHistory::levelForStride(1) == 0);
+        REQUIRE(SimulationHistory::levelForStride(3) == 1);
+        REQUIRE(SimulationHistory::levelForStride(4) == 2);
+        REQUIRE(SimulationHistory::levelForStride(1u << 30)
+                == HISTORY_LEVELS - 1);
+    }
+
     SECTION("Clear data") {
         history.clear();
         REQUIRE(history.universeSize() == 0);
@@ -118,18 +147,176 @@ TEST_CASE("Normal usage")
     }
 
     SECTION("Clear data from index 2") {
+        const unsigned long revision = history.revision();
         history.clear(2);
+        REQUIRE(history.revision() != revision);
         REQUIRE(history.universeSize() == 1);
         REQUIRE(history.historySize() == 2);
         REQUIRE(history.bodyPositions(0).size() == 2 * 3);
+        REQUIRE(history.bodyPositions(0, 1).size() == 1 * 3);
         REQUIRE(!history.empty());
     }
 
     SECTION("Clear data from index 3 (invalid)") {
+        const unsigned long revision = history.revision();
         history.clear(3);  // nothing should happen
+        REQUIRE(history.revision() == revision);
         REQUIRE(history.universeSize() == 1);
         REQUIRE(history.historySize() == 3);
         REQUIRE(history.bodyPositions(0).size() == 3 * 3);
         REQUIRE(!history.empty());
     }
 }
+
+TEST_CASE("Interpolation between saved states")
+{
+    SimulationHistory history;
+    physics::Body planet;
+    planet.position.set(0, 0, 0);
+    planet.velocity.set(1, 2, 0);
+    physics::UniverseModel universe {planet};
+    physics::SimulationTime time;
+    time.setTimeStep(10);
+
+    // the planet moves in a straight line with a constant velocity
+    for(unsigned i = 0; i < 3; i++) {
+        universe[0].position = planet.velocity * time.time();
+        history.save(universe, time);
+        time.updateTime();
+    }
+
+    SECTION("Saved times") {
+        REQUIRE(physics::equal(history.savedTime(0), 0));
+        REQUIRE(physics::equal(history.savedTime(2), 20));
+        REQUIRE_THROWS(history.savedTime(3));
+    }
+
+    SECTION("Seek time") {
+        HistoryPosition position = history.seek(15);
+        REQUIRE(position.index == 1);
+        REQUIRE(position.next == 2);
+        REQUIRE(physics::equal(position.factor, 0.5));
+        position = history.seek(20);
+        REQUIRE(position.index == 2);
+        REQUIRE(position.next == 2);
+        position = history.seek(-1);
+        REQUIRE(position.index == 0);
+        REQUIRE(physics::equal(position.factor, 0));
+        REQUIRE_THROWS(SimulationHistory().seek(0));
+    }
+
+    SECTION("Time window") {
+        unsigned first = 0;
+        auto spans = history.window(5, 20, &first);
+        REQUIRE(first == 1);
+        REQUIRE(spans.size() == 1);
+        REQUIRE(spans[0].vertexCount() == 2);
+        REQUIRE(qFuzzyCompare(spans[0].vertex(0), QVector3D(10, 20, 0)));
+        REQUIRE(history.window(21, 30)[0].empty());
+    }
+
+    SECTION("At a saved state") {
+        QVector3D vector = history.interpolatedBodyPosition(0, 10);
+        REQUIRE(qFuzzyCompare(vector, QVector3D(10, 20, 0)));
+    }
+
+    SECTION("Between saved states") {
+        QVector3D vector = history.interpolatedBodyPosition(0, 12.5);
+        REQUIRE(qFuzzyCompare(vector, QVector3D(12.5, 25, 0)));
+    }
+
+    SECTION("Outside of the saved range") {
+        QVector3D vector = history.interpolatedBodyPosition(0, -5);
+        REQUIRE(qFuzzyCompare(vector, QVector3D(0, 0, 0)));
+        vector = history.interpolatedBodyPosition(0, 100);
+        REQUIRE(qFuzzyCompare(vector, QVector3D(20, 40, 0)));
+        REQUIRE_THROWS(history.interpolatedBodyPosition(1, 0));
+    }
+}
+
+TEST_CASE("Keyframes with full precision")
+{
+    SimulationHistory history;
+    physics::Body planet;
+    planet.position.set(1.000000000001, 0, 0);
+    physics::UniverseModel universe {planet};
+    physics::SimulationTime time;
+    algorithms::AdamsBashforth algorithm {4};
+
+    REQUIRE(history.keyframe(0) == nullptr);
+    for(unsigned i = 0; i < KEYFRAME_INTERVAL + 2; i++) {
+        history.save(universe, time, &algorithm);
+        time.updateTime();
+    }
+    // without an algorithm, no keyframe can be saved
+    history.save(universe, time, nullptr, true);
+
+    SECTION("Find the previous keyframe") {
+        REQUIRE(history.keyframe(0)->index == 0);
+        REQUIRE(history.keyframe(KEYFRAME_INTERVAL - 1)->index == 0);
+        REQUIRE(history.keyframe(KEYFRAME_INTERVAL)->index
+                == KEYFRAME_INTERVAL);
+        REQUIRE(history.keyframe(KEYFRAME_INTERVAL + 2)->index
+                == KEYFRAME_INTERVAL);
+    }
+
+    SECTION("Keyframe content") {
+        const Keyframe *keyframe = history.keyframe(0);
+        REQUIRE(keyframe->positions.size() == 1);
+        REQUIRE(keyframe->positions[0].x() == planet.position.x());
+        REQUIRE(keyframe->algorithm == algorithms::T_AB4);
+        REQUIRE(physics::equal(keyframe->time_step, time.timeStep()));
+    }
+
+    SECTION("Forced keyframe") {
+        history.save(universe, time, &algorithm, true);
+        REQUIRE(history.keyframe(KEYFRAME_INTERVAL + 3)->index
+                == KEYFRAME_INTERVAL + 3);
+    }
+
+    SECTION("Clear keyframes") {
+        history.clear(KEYFRAME_INTERVAL);
+        REQUIRE(history.keyframe(KEYFRAME_INTERVAL)->index == 0);
+        history.clear();
+        REQUIRE(history.keyframe(0) == nullptr);
+    }
+}
+
+TEST_CASE("Positions relative to an origin body")
+{
+    SimulationHistory history;
+    physics::Body earth, moon;
+    // too far from [0, 0, 0] to tell the two bodies apart in float
+    earth.position.set(1.5e11, 0, 0);
+    earth.velocity.set(0, 3e4, 0);
+    moon.position.set(1.5e11 + 1234.5, 0, 0);
+    moon.velocity.set(0, 3e4 + 1, 0);
+    physics::UniverseModel universe {earth, moon};
+    physics::SimulationTime time;
+
+    history.setOrigin(0);
+    REQUIRE(history.hasOrigin());
+    history.save(universe, time);
+    REQUIRE_THROWS(history.setOrigin(1));
+
+    SECTION("Relative positions keep the precision") {
+        REQUIRE(history.bodyPosition(0, 0) == QVector3D(0, 0, 0));
+        REQUIRE(history.bodyPosition(1, 0).x() == Approx(1234.5));
+        REQUIRE(history.bodyPositions(1, 0).vertex(0).x() == Approx(1234.5));
+        REQUIRE(physics::equal(history.originPosition(0).x(), 1.5e11));
+    }
+
+    SECTION("Load absolute positions") {
+        physics::UniverseModel loaded {physics::Body(), physics::Body()};
+        history.load(0, &loaded, &time);
+        REQUIRE(std::abs(loaded[0].position.x() - 1.5e11) < 1e-3);
+        REQUIRE(std::abs(loaded[1].position.x() - (1.5e11 + 1234.5)) < 1e-3);
+        REQUIRE(std::abs(loaded[1].velocity.y() - (3e4 + 1)) < 1e-3);
+    }
+
+    SECTION("Origin out of range") {
+        history.clear();
+        history.setOrigin(2);
+        REQUIRE_THROWS(history.save(universe, time));
+    }
+}
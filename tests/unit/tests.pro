@@ -11,10 +11,24 @@ SOURCES +=  tests.cpp\
             test_algorithms.cpp\
             test_vector.cpp\
             test_simulation_history.cpp\
+            test_output.cpp\
+            test_generators.cpp\
+            test_horizons.cpp\
 
 
 # files not included in common.pri (because they are not used by both the CLI
 # and GUI)
 HEADERS += $$PROJ_DIR"/src/simulationhistory.h"\
+           $$PROJ_DIR"/src/output/writer.h"\
+           $$PROJ_DIR"/src/output/textwriter.h"\
+           $$PROJ_DIR"/src/output/npywriter.h"\
+           $$PROJ_DIR"/src/output/asyncwriter.h"\
+           $$PROJ_DIR"/src/output/compression.h"\
+           $$PROJ_DIR"/src/horizons.h"\
 
 SOURCES += $$PROJ_DIR"/src/simulationhistory.cpp"\
+           $$PROJ_DIR"/src/output/textwriter.cpp"\
+           $$PROJ_DIR"/src/output/npywriter.cpp"\
+           $$PROJ_DIR"/src/output/asyncwriter.cpp"\
+           $$PROJ_DIR"/src/output/compression.cpp"\
+           $$PROJ_DIR"/src/horizons.cpp"\